@@ -0,0 +1,240 @@
+/* ESP32 decode replay, runs captured One Call and News responses through the decoders and reports their cost.
+  ####################################################################################################################################
+  This software, the ideas and concepts is Copyright (c) David Bird 2018. All rights to this software are reserved.
+
+  Any redistribution or reproduction of any part or all of the contents in any form is prohibited other than the following:
+  1. You may print or download to a local hard disk extracts for your personal and non-commercial use only.
+  2. You may copy the content to individual third parties for their personal use, but only if you acknowledge the author David Bird as the source of the material.
+  3. You may not, except with my express written permission, distribute or commercially exploit the content.
+  4. You may not transmit it or store it in any other website or other form of electronic retrieval system for commercial purposes.
+
+  The above copyright ('as annotated') notice and this permission notice shall be included in all copies or substantial portions of the Software and where the
+  software use is visible to an end-user.
+
+  THE SOFTWARE IS PROVIDED "AS IS" FOR PRIVATE USE ONLY, IT IS NOT FOR COMMERCIAL USE IN WHOLE OR PART OR CONCEPT. FOR PERSONAL USE IT IS SUPPLIED WITHOUT WARRANTY
+  OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHOR OR COPYRIGHT HOLDER BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+  See more at http://www.dsbird.org.uk
+
+  Use this to judge a decoder or record layout change without a display or network, on the chip that runs it.
+  The decoded fields can be checked without a board at all by the host replay in test/ (make -C test), which
+  decodes the responses in test/corpus and compares each field with its expected value. This sketch measures what
+  only the chip can, the decode time and peak heap.
+  Capture response bodies e.g. with curl, one file each, and upload them to LittleFS in a /corpus folder:
+     <lang>_<metric|imperial>_<place>.json   a One Call 3.0 response, e.g. cz_metric_prague.json, en_imperial_nome.json
+     news_<source>.json                      a News API top-headlines response
+  A useful corpus has each of the lang_xx.h languages, both units, a polar location (no sunrise or sunset in
+  summer and winter) and a location with weather alerts.
+
+  Each file is decoded by the ArduinoJson decoder and the streaming decoder, REPLAY_RUNS times each, and for each
+  the latency percentiles, the peak heap and every decoded field are printed. The decoded fields are then put
+  through the wire format (see wire_format.h) and back, and its size and decode time are printed, and whether the
+  fields came back the same. The ESP32 can't reset its heap low-water mark, so the chip restarts between decodes
+  and keeps the results in RTC memory until the summary.
+*/
+#include <ArduinoJson.h>              // https://github.com/bblanchon/ArduinoJson needs version v6 or above
+#include <WiFi.h>                     // Built-in
+#include <HTTPClient.h>               // Built-in
+#include <LittleFS.h>                 // Built-in
+#include "esp_rom_crc.h"              // Built-in
+#include <algorithm>
+
+const char server[]  = "api.openweathermap.org"; // Not contacted, but needed by common.h
+String apikey        = "";
+String LAT           = "0";
+String LON           = "0";
+String Language      = "EN";
+String Units         = "M";           // Set from each file name
+
+#define max_readings 24
+#include "common.h"
+#include "news.h"
+#include "wire_format.h"
+
+#define REPLAY_FOLDER    "/corpus"
+#define REPLAY_RUNS      25           // Decodes of each file by each decoder
+#define REPLAY_MAX_FILES 32
+#define REPLAY_DECODERS  2
+#define REPLAY_MAGIC     0x52504C59
+
+typedef struct {
+  bool     Decoded;
+  uint32_t P50, P90, P99;             // Decode time, us
+  uint32_t PeakHeap;                  // bytes
+  bool     PeakBound;                 // PeakHeap is only an upper bound, the low-water mark was set before decoding
+  uint32_t Snapshot;                  // CRC of the decoded fields, equal for both decoders if they agree
+  uint32_t JsonSize;                  // bytes
+  uint32_t WireSize;                  // bytes, see wire_format.h
+  uint32_t WireTime;                  // us to decode it
+  bool     WireSame;                  // Decoding it gave the same fields
+} Replay_result_type;
+
+RTC_NOINIT_ATTR uint32_t           ReplayMagic;
+RTC_NOINIT_ATTR int                ReplayStep;
+RTC_NOINIT_ATTR Replay_result_type Results[REPLAY_MAX_FILES * REPLAY_DECODERS];
+
+String FileNames[REPLAY_MAX_FILES];
+int    FileCount = 0;
+
+const char*       DecoderNames[REPLAY_DECODERS] = {"ArduinoJson", "Streaming"};
+Body_decoder_type Decoders[REPLAY_DECODERS]     = {DecodeOneCallWeather, DecodeOneCallStreamed};
+
+bool ListCorpus();
+void ReplayOne(int f, int d);
+void PrintRecords(Print& out);
+void PrintHeadlines(Print& out);
+void PrintSummary();
+void ReplayWire(Replay_result_type& result);
+
+//#########################################################################################
+// Prints the decoded fields and keeps a CRC of them, so the two decoders can be compared in the summary
+class SnapshotPrint : public Print {
+  public:
+    SnapshotPrint(bool echo = true) : _crc(0), _echo(echo) {}
+    size_t write(uint8_t c) override {
+      _crc = esp_rom_crc32_le(_crc, &c, 1);
+      return _echo ? Serial.write(c) : 1;
+    }
+    uint32_t Crc() { return _crc; }
+  private:
+    uint32_t _crc;
+    bool     _echo;
+};
+
+//#########################################################################################
+void setup() {
+  Serial.begin(115200);
+  if (ReplayMagic != REPLAY_MAGIC || esp_reset_reason() != ESP_RST_SW) { // A fresh run after power-on or upload
+    ReplayMagic = REPLAY_MAGIC;
+    ReplayStep  = 0;
+  }
+  if (!LittleFS.begin() || !ListCorpus()) {
+    Serial.println("No files in " REPLAY_FOLDER ", upload a corpus to LittleFS");
+    return;
+  }
+  if (ReplayStep < FileCount * REPLAY_DECODERS) {
+    ReplayOne(ReplayStep / REPLAY_DECODERS, ReplayStep % REPLAY_DECODERS);
+    ReplayStep++;
+    Serial.flush();
+    esp_restart(); // Starts the next decode with a fresh heap low-water mark
+  }
+  PrintSummary();
+  ReplayMagic = 0;
+}
+//#########################################################################################
+void loop() {
+}
+//#########################################################################################
+bool ListCorpus() {
+  File folder = LittleFS.open(REPLAY_FOLDER);
+  if (!folder || !folder.isDirectory()) return false;
+  File file;
+  while ((file = folder.openNextFile()) && FileCount < REPLAY_MAX_FILES) {
+    if (!file.isDirectory()) FileNames[FileCount++] = file.name();
+  }
+  for (int i = 1; i < FileCount; i++) { // Sorted, so the order is the same after every restart
+    for (int j = i; j > 0 && FileNames[j].compareTo(FileNames[j - 1]) < 0; j--) {
+      String name = FileNames[j];
+      FileNames[j] = FileNames[j - 1];
+      FileNames[j - 1] = name;
+    }
+  }
+  return FileCount > 0;
+}
+//#########################################################################################
+void ReplayOne(int f, int d) {
+  Replay_result_type& result = Results[f * REPLAY_DECODERS + d];
+  memset(&result, 0, sizeof(result));
+  bool news = FileNames[f].startsWith("news");
+  if (news && d > 0) return; // News has a single decoder
+  Units = FileNames[f].indexOf("imperial") >= 0 ? "I" : "M";
+  File file = LittleFS.open(String(REPLAY_FOLDER) + "/" + FileNames[f]);
+  size_t   size;
+  uint8_t* body = ReadBody(file, file.size(), size);
+  file.close();
+  if (body == NULL) {
+    Serial.println(FileNames[f] + " is too large to replay");
+    return;
+  }
+  result.JsonSize = size;
+  Body_decoder_type decoder = news ? DecodeNewsHeadlines : Decoders[d];
+  uint32_t baseline  = ESP.getFreeHeap();
+  uint32_t lowBefore = ESP.getMinFreeHeap();
+  uint32_t times[REPLAY_RUNS];
+  for (int run = 0; run < REPLAY_RUNS; run++) {
+    BufferStream json(body, size);
+    uint32_t start = micros();
+    result.Decoded = decoder(json, false);
+    times[run] = micros() - start;
+    if (run == 0) {
+      uint32_t lowAfter = ESP.getMinFreeHeap();
+      result.PeakHeap   = baseline - lowAfter;
+      result.PeakBound  = lowAfter == lowBefore;
+    }
+  }
+  free(body);
+  std::sort(times, times + REPLAY_RUNS);
+  result.P50 = times[REPLAY_RUNS * 50 / 100];
+  result.P90 = times[REPLAY_RUNS * 90 / 100];
+  result.P99 = times[REPLAY_RUNS * 99 / 100];
+  Serial.println("\n" + FileNames[f] + " " + String(size) + " bytes, " + (news ? "News" : DecoderNames[d]) + (result.Decoded ? "" : " FAILED"));
+  SnapshotPrint snapshot;
+  if (news) PrintHeadlines(snapshot);
+  else PrintRecords(snapshot);
+  result.Snapshot = snapshot.Crc();
+  if (!news && result.Decoded) ReplayWire(result);
+}
+//#########################################################################################
+// Encodes the decoded records in the wire format, then decodes them again into cleared records and compares them
+void ReplayWire(Replay_result_type& result) {
+  uint8_t wire[WIRE_MAX_SIZE];
+  result.WireSize = EncodeWire(wire, sizeof(wire), true);
+  WxConditions[0] = Forecast_record_type();
+  for (int r = 0; r < max_readings; r++) WxForecast[r] = Forecast_record_type();
+  for (int r = 0; r < 8; r++) Daily[r] = Forecast_record_type();
+  uint32_t start = micros();
+  bool decoded = DecodeWire(wire, result.WireSize);
+  result.WireTime = micros() - start;
+  SnapshotPrint snapshot(false);
+  PrintRecords(snapshot);
+  result.WireSame = decoded && snapshot.Crc() == result.Snapshot;
+  Serial.println("Wire format " + String(result.WireSize) + " bytes, decoded in " + String(result.WireTime) + "-us, " + (result.WireSame ? "same fields" : "fields DIFFER"));
+}
+//#########################################################################################
+void PrintRecords(Print& out) {
+  Forecast_record_type& c = WxConditions[0];
+  out.printf("current tz=%d sunrise=%d sunset=%d temp=%.2f feels=%.2f pres=%.2f humi=%.0f dew=%.2f uvi=%.2f clouds=%d vis=%d wspd=%.2f wdir=%.0f trend=%s icon=%s desc=%s\n",
+             c.Timezone, c.Sunrise, c.Sunset, c.Temperature, c.FeelsLike, c.Pressure, c.Humidity, c.DewPoint, c.UVI, c.Cloudcover,
+             c.Visibility, c.Windspeed, c.Winddir, c.Trend.c_str(), c.Icon.c_str(), c.Description.c_str());
+  for (int r = 0; r < max_readings; r++) {
+    Forecast_record_type& h = WxForecast[r];
+    out.printf("hourly[%d] dt=%d temp=%.2f feels=%.2f pres=%.2f humi=%.0f dew=%.2f pop=%.2f rain=%.2f snow=%.2f icon=%s\n",
+               r, h.Dt, h.Temperature, h.FeelsLike, h.Pressure, h.Humidity, h.DewPoint, h.PoP, h.Rainfall, h.Snowfall, h.Icon.c_str());
+  }
+  for (int r = 0; r < 8; r++) {
+    Forecast_record_type& d = Daily[r];
+    out.printf("daily[%d] dt=%d temp=%.2f high=%.2f low=%.2f humi=%.0f pop=%.2f uvi=%.2f rain=%.2f snow=%.2f icon=%s summary=%s\n",
+               r, d.Dt, d.Temperature, d.High, d.Low, d.Humidity, d.PoP, d.UVI, d.Rainfall, d.Snowfall, d.Icon.c_str(), d.Description.c_str());
+  }
+}
+//#########################################################################################
+void PrintHeadlines(Print& out) {
+  for (int h = 0; h < HeadlineCount; h++) out.printf("headline[%d] source=%s title=%s\n", h, Headlines[h].Source, Headlines[h].Title);
+}
+//#########################################################################################
+void PrintSummary() {
+  Serial.println("\nDecode replay summary, " + String(REPLAY_RUNS) + " runs per file");
+  Serial.println("File                              Decoder      p50-us   p90-us   p99-us  peak-heap  fields  wire-bytes wire-us  round-trip");
+  for (int f = 0; f < FileCount; f++) {
+    bool news = FileNames[f].startsWith("news");
+    for (int d = 0; d < (news ? 1 : REPLAY_DECODERS); d++) {
+      Replay_result_type& result = Results[f * REPLAY_DECODERS + d];
+      const char* fields = !result.Decoded ? "FAILED" : news ? "" : result.Snapshot == Results[f * REPLAY_DECODERS].Snapshot ? "same" : "DIFFER";
+      Serial.printf("%-33s %-11s %8u %8u %8u %s%8u  %-6s", FileNames[f].c_str(), news ? "News" : DecoderNames[d],
+                    result.P50, result.P90, result.P99, result.PeakBound ? "<" : " ", result.PeakHeap, fields);
+      if (result.WireSize > 0) Serial.printf("  %10u %7.1f%% %7u  %s\n", result.WireSize, 100.0 * result.WireSize / result.JsonSize, result.WireTime, result.WireSame ? "same" : "DIFFER");
+      else Serial.println();
+    }
+  }
+}
@@ -0,0 +1,147 @@
+/* ESP32 LAN weather gateway, fetches the forecast once for every panel on the network and serves it as a snapshot.
+  ####################################################################################################################################
+  This software, the ideas and concepts is Copyright (c) David Bird 2018. All rights to this software are reserved.
+
+  Any redistribution or reproduction of any part or all of the contents in any form is prohibited other than the following:
+  1. You may print or download to a local hard disk extracts for your personal and non-commercial use only.
+  2. You may copy the content to individual third parties for their personal use, but only if you acknowledge the author David Bird as the source of the material.
+  3. You may not, except with my express written permission, distribute or commercially exploit the content.
+  4. You may not transmit it or store it in any other website or other form of electronic retrieval system for commercial purposes.
+
+  The above copyright ('as annotated') notice and this permission notice shall be included in all copies or substantial portions of the Software and where the
+  software use is visible to an end-user.
+
+  THE SOFTWARE IS PROVIDED "AS IS" FOR PRIVATE USE ONLY, IT IS NOT FOR COMMERCIAL USE IN WHOLE OR PART OR CONCEPT. FOR PERSONAL USE IT IS SUPPLIED WITHOUT WARRANTY
+  OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+  IN NO EVENT SHALL THE AUTHOR OR COPYRIGHT HOLDER BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+  See more at http://www.dsbird.org.uk
+
+  Run this on a mains powered ESP32 and set Gateway in each panel's owm_credentials.h to its address. Every
+  GATEWAY_INTERVAL minutes the gateway fetches each location in its list from OWM, over one connection, and
+  then answers the panels with the decoded forecast in the wire format (see snapshot.h and wire_format.h), so 20
+  panels cost one One Call request. The format doesn't depend on the ESP32, so a gateway on any other host only
+  has to serve the same bytes, see test/test_snapshot.cpp.
+  A panel whose location isn't in the list, or can't reach the gateway, fetches from OWM itself.
+  To check it from any computer on the LAN:
+     curl -s "http://<gateway address>:8080/snapshot?lat=51.38&lon=-2.36" | xxd | head
+  and /status lists the locations and the age of each.
+  With a PushKey set, each location is also broadcast by ESP-NOW every PUSH_PERIOD ms, for panels that don't join
+  WiFi at all. They must be set to this gateway's WiFi channel, shown by /status.
+*/
+#include "owm_credentials.h"          // See 'owm_credentials' tab and enter your OWM API key and set the Wifi SSID and PASSWORD
+#include <ArduinoJson.h>              // https://github.com/bblanchon/ArduinoJson needs version v6 or above
+#include <WiFi.h>                     // Built-in
+#include <HTTPClient.h>               // Built-in
+#include <WebServer.h>                // Built-in
+#include "time.h"                     // Built-in
+
+#define max_readings 24               // Must be the same as the panels'
+#include "common.h"
+#include "http_fetch.h"
+#include "wire_format.h"
+#include "locations.h"
+#include "snapshot.h"
+#include "espnow_push.h"
+
+#define GATEWAY_INTERVAL 30           // Minutes between fetches, the panels' SleepDuration or less
+#define PUSH_PERIOD      250          // ms between ESP-NOW broadcasts of each location, well inside a panel's PUSH_LISTEN_TIME
+
+Location_type Locations[] = { // Served to the panels, up-to LOCATION_MAX e.g. {"BATH", "51.38", "-2.36"},
+  {City, LAT, LON},
+};
+const int LocationCount = sizeof(Locations) / sizeof(Locations[0]);
+
+WebServer     Server(SNAPSHOT_PORT);
+unsigned long LastFetch = 0;
+unsigned long Served    = 0;
+unsigned long LastPush  = 0;
+
+void FetchLocations();
+void PushLocations();
+void HandleSnapshot();
+void HandleStatus();
+bool StartWiFi();
+
+//#########################################################################################
+void setup() {
+  Serial.begin(115200);
+  while (!StartWiFi()) delay(5000);
+  configTime(0, 0, ntpServer, "time.nist.gov"); // Records are timed in UTC, the panels show their own local time
+  setenv("TZ", Timezone, 1);
+  tzset();
+  struct tm timeinfo;
+  while (!getLocalTime(&timeinfo, 10000)) Serial.println("Failed to obtain time");
+  Server.on(SNAPSHOT_PATH, HandleSnapshot);
+  Server.on("/status", HandleStatus);
+  Server.begin();
+  Serial.println("Gateway serving on " + WiFi.localIP().toString() + ":" + String(SNAPSHOT_PORT));
+  FetchLocations();
+}
+//#########################################################################################
+void loop() {
+  Server.handleClient();
+  if (WiFi.status() != WL_CONNECTED) StartWiFi();
+  else if (millis() - LastFetch >= GATEWAY_INTERVAL * 60000UL) FetchLocations();
+  else if (strlen(PushKey) > 0 && millis() - LastPush >= PUSH_PERIOD) PushLocations();
+  delay(2);
+}
+//#########################################################################################
+void FetchLocations() {
+  int wanted[LOCATION_MAX];
+  for (int l = 0; l < LocationCount; l++) wanted[l] = l;
+  int ready = RefreshLocations(Locations, wanted, LocationCount, GATEWAY_INTERVAL * 60 - 60, false);
+  Serial.println(String(ready) + " of " + String(LocationCount) + " location(s) ready, " + String(Served) + " snapshot(s) served so far");
+  LastFetch = millis();
+}
+//#########################################################################################
+// Broadcasts each location's record, already in the wire format without the texts, so it fits in three ESP-NOW frames
+void PushLocations() {
+  for (int l = 0; l < LocationCount; l++) {
+    if (LocationFresh(Locations[l], l, LOCATION_MAX_STALE)) SendPush(PushKey, LocationRecords[l].Wire, LocationRecords[l].Size, LocationPlace(Locations[l]));
+  }
+  LastPush = millis();
+}
+//#########################################################################################
+void HandleSnapshot() {
+  String lat = Server.arg("lat");
+  String lon = Server.arg("lon");
+  int l = 0;
+  while (l < LocationCount && !(Locations[l].Lat == lat && Locations[l].Lon == lon)) l++;
+  if (l == LocationCount) {
+    Server.send(404, "text/plain", "Location not served");
+    return;
+  }
+  if (!LocationFresh(Locations[l], l, LOCATION_MAX_STALE)) {
+    Server.send(503, "text/plain", "No forecast yet");
+    return;
+  }
+  Location_record_type& record = LocationRecords[l]; // Already in the wire format
+  Server.sendHeader("Age", String((uint32_t)time(NULL) - record.Fetched));
+  Server.send_P(200, "application/octet-stream", (PGM_P)record.Wire, record.Size);
+  Served++;
+}
+//#########################################################################################
+void HandleStatus() {
+  String status = "Wire format version " + String(WIRE_VERSION) + ", " + String(Served) + " snapshots served\n";
+  status += "WiFi channel " + String(WiFi.channel()) + (strlen(PushKey) > 0 ? ", pushing by ESP-NOW\n" : "\n");
+  for (int l = 0; l < LocationCount; l++) {
+    Location_record_type& record = LocationRecords[l];
+    status += Locations[l].Name + " " + Locations[l].Lat + "," + Locations[l].Lon + ": ";
+    status += record.Fetched == 0 ? String("not fetched\n") : String(record.Size) + " bytes fetched " + String((uint32_t)time(NULL) - record.Fetched) + "-secs ago\n";
+  }
+  Server.send(200, "text/plain", status);
+}
+//#########################################################################################
+bool StartWiFi() {
+  Serial.print("\r\nConnecting to: "); Serial.println(String(ssid));
+  WiFi.disconnect();
+  WiFi.mode(WIFI_STA);
+  WiFi.setSleep(false); // Mains powered, so answer the panels without modem sleep latency
+  WiFi.begin(ssid, password);
+  unsigned long start = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - start < 15000) delay(50);
+  if (WiFi.status() == WL_CONNECTED) Serial.println("WiFi connected at: " + WiFi.localIP().toString());
+  else Serial.println("WiFi connection *** FAILED ***");
+  return WiFi.status() == WL_CONNECTED;
+}
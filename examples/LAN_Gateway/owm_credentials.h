@@ -0,0 +1,17 @@
+// Change to your WiFi credentials
+const char* ssid     = "your_SSID";     // WiFi SSID to connect to
+const char* password = "your_PASSWORD"; // WiFi password needed for the SSID
+
+// Use your own API key by signing up for a free developer account at https://openweathermap.org/
+String apikey       = "your_API_key";                      // See: https://openweathermap.org/  // It's free to get an API key, but don't take more than 60 readings/minute!
+const char server[] = "api.openweathermap.org";
+
+//Set the location served, more can be added to the Locations list in the sketch
+String LAT              = "51.38";                         // Home location Latitude
+String LON              = "-2.36";                         // Home location Longitude
+String City             = "MELKSHAM";                      // Your home city See: http://bulk.openweathermap.org/sample/
+String Language         = "EN";                            // NOTE: Only the weather description is translated by OWM
+String Units            = "M";                             // Use 'M' for Metric or I for Imperial, must be the same as the panels'
+const char* Timezone    = "GMT0BST,M3.5.0/01,M10.5.0/02";  // Choose your time zone from: https://github.com/nayarsystems/posix_tz_db/blob/master/zones.csv
+const char* PushKey     = "";                              // Shared with the panels, to also broadcast the forecasts by ESP-NOW (see espnow_push.h)
+const char* ntpServer   = "0.uk.pool.ntp.org";             // Or, choose a time server close to you, but in most cases it's best to use pool.ntp.org to find an NTP server
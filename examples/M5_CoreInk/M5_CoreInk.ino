@@ -63,7 +63,7 @@ int     StartTime, CurrentHour = 0, CurrentMin = 0, CurrentSec = 0;
 
 //################ PROGRAM VARIABLES and OBJECTS ################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
 
 #define max_readings 4
 
@@ -72,7 +72,7 @@ long       StartTime = 0;
 
 //################ PROGRAM VARIABLES and OBJECTS ################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
 
 #define max_readings 24
 
@@ -86,7 +86,7 @@ long    StartTime = 0;
 
 //################ PROGRAM VARIABLES and OBJECTS ##########################################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
 
 #define max_readings 25 // In groups of 3-hours (3-days = 3 x 8 = 24)
 Forecast_record_type  WxConditions[1];
@@ -60,7 +60,17 @@ static const uint8_t EPD_MOSI = 23; // to EPD DIN
 //static const uint8_t EPD_MISO = 12; // Master-In Slave-Out not used, as no data from display
 //static const uint8_t EPD_MOSI = 14;
 
+//#define RENDER_SERVER // Build to draw this display for other panels of the same type, which then only download it (see bitmap_codec.h)
+// The render server is this sketch on a second, mains powered ESP32, not a program for a PC: drawing needs the same
+// GxEPD2, U8g2 and Adafruit GFX code the panel runs, so it is drawn into a FrameCanvas and served on RENDER_PORT at
+// RENDER_PATH. It only draws this 7.5" 640x384 black and white layout, so only panels built from this sketch use it.
+#ifdef RENDER_SERVER
+#include <WebServer.h>
+#include "frame_canvas.h"
+FrameCanvas display(SCREEN_WIDTH, SCREEN_HEIGHT);
+#else
 GxEPD2_BW<GxEPD2_750, GxEPD2_750::HEIGHT> display(GxEPD2_750(/*CS=*/ EPD_CS, /*DC=*/ EPD_DC, /*RST=*/ EPD_RST, /*BUSY=*/ EPD_BUSY));   // B/W display
+#endif
 //Try each to suit your display
 //GxEPD2_BW<GxEPD2_750_T7, GxEPD2_750_T7::HEIGHT> display(GxEPD2_750_T7(/*CS=5*/ SS, /*DC=*/ 17, /*RST=*/ 16, /*BUSY=*/ 4)); // GDEW075T7 800x480, EK79655 (GD7965)
 //GxEPD2_BW<GxEPD2_750_GDEY075T7, GxEPD2_750_GDEY075T7::HEIGHT> display(GxEPD2_750_GDEY075T7(/*CS=5*/ SS, /*DC=*/ 17, /*RST=*/ 16, /*BUSY=*/ 4)); // GDEY075T7 800x480, UC8179 (GD7965)
@@ -84,15 +94,40 @@ boolean LargeIcon = true, SmallIcon = false;
 #define Large  15           // For icon drawing, needs to be odd number for best effect
 #define Small  5            // For icon drawing, needs to be odd number for best effect
 String  Time_str, Date_str; // strings to hold time and received weather data
-int     wifi_signal, CurrentHour = 0, CurrentMin = 0, CurrentSec = 0;
+int     CurrentHour = 0, CurrentMin = 0, CurrentSec = 0;
+RTC_DATA_ATTR int wifi_signal; // Kept for a touch view, which doesn't start WiFi
 long    StartTime = 0;
 
 //################ PROGRAM VARIABLES and OBJECTS ################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
 
 #define max_readings 24
 #include "common.h"
+#include "http_fetch.h"
+#include "wire_format.h"
+#include "locations.h"
+#include "snapshot.h"
+#include "espnow_push.h"
+#include "bitmap_codec.h"
+#include "busy_sleep.h"
+#include "schedule.h"
+#include "cadence.h"
+#include "battery.h"
+#include "wake_budget.h"
+#include "backoff.h"
+#include "stagger.h"
+
+#ifdef RENDER_SERVER
+WebServer RenderServer(RENDER_PORT);
+#endif
+
+Location_type Locations[] = { // Shown in turn, one per wake, add up-to LOCATION_MAX e.g. {"BATH", "51.38", "-2.36"},
+  {City, LAT, LON},
+};
+const int LocationCount = sizeof(Locations) / sizeof(Locations[0]);
+String    LocationName  = City;
+float     PanelVoltage  = -1; // Battery voltage sent by a panel to a render server, which has no battery of its own
 
 #define autoscale_on  true
 #define autoscale_off false
@@ -104,38 +139,208 @@ float temperature_readings[max_readings] = {0};
 float humidity_readings[max_readings]    = {0};
 float rain_readings[max_readings]        = {0};
 float snow_readings[max_readings]        = {0};
+float pop_readings[max_readings]         = {0};
 
 long SleepDuration = 30; // Sleep time in minutes, aligned to the nearest minute boundary, so if 30 will always update at 00 or 30 past the hour
 int  WakeupTime    = 7;  // Don't wakeup until after 07:00 to save battery power
 int  SleepTime     = 23; // Sleep after (23+1) 00:00 to save battery power
+Schedule_rule_type Schedule[] = { // When to update the display, see schedule.h e.g. {SCHEDULE_WEEKDAYS, 7 * 60, 18 * 60, 15},
+  {SCHEDULE_EVERY_DAY, WakeupTime * 60, (SleepTime + 1) * 60, (int)SleepDuration},
+};
+const int ScheduleCount = sizeof(Schedule) / sizeof(Schedule[0]);
+Cadence_type Cadence = {(int)SleepDuration, 4 * (int)SleepDuration, 1.0, 0.2, 1.0}; // Sleep range and the most each may change by, see cadence.h, MaxSleep as MinSleep for a fixed cadence
+long CadenceSleep    = 0; // Minutes, set once the forecast is shown
+Battery_type Battery = {3.65, 3.55, 3.50, 3.40, 1.0}; // Volts each level starts below and the calibration, see battery.h
+
+#define TOUCH_VIEWS 3 // A touch shows the next of: the forecast display, the hourly graphs and the 8-day forecast
+RTC_DATA_ATTR uint8_t TouchView = 0;
+RTC_DATA_ATTR time_t  NextWake  = 0; // The update planned before a touch, which a touch view keeps to
+bool ViewShown = false;
+Budget_type Budget = {4000, 5000, 8000}; // ms since boot by which WiFi is joined, the clock set and the forecast fetched, see wake_budget.h
+bool Stale = false; // The forecast shown wasn't fetched in time
+long     StaggerSpread = SleepDuration * 60; // secs a fleet's updates are spread over, 0 for none, see stagger.h
+uint32_t Stagger       = 0;                  // secs this panel's updates are after the scheduled times
+const Cpu_profile_type& CpuBoard = CpuESP32; // The board's processor, for its clocks and currents, see cpu_clock.h
+unsigned long ClockWait = 10000; // ms UpdateLocalTime() waits for the time to be set
 //#########################################################################################
 void setup() {
   StartTime = millis();
   Serial.begin(115200);
-  if (StartWiFi() == WL_CONNECTED && SetupTime() == true) {
-    Serial.println("WiFi and Time services started...");
-    if ((CurrentHour >= WakeupTime && CurrentHour <= SleepTime)) {
+#ifdef RENDER_SERVER
+  StartRenderServer();
+  return;
+#endif
+  CpuClockBegin(CpuBoard); // At the I/O clock until there's decoding or drawing to do
+  Stagger = StaggerOffset(StaggerSpread);
+  int WasLevel = BatteryLevel;
+  if (CheckBattery(Battery) == BATTERY_EMPTY) {
+    if (WasLevel != BATTERY_EMPTY) DisplayLowBattery(); // Only once, as it stays on the panel
+    BeginSleep();
+  }
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD && ShowTouchView()) BeginSleep(); // Drawn from RTC memory, with no radio
+  int  Shown  = NextLocation(LocationCount);
+  unsigned long Listen = millis();
+  bool Pushed = strlen(PushKey) > 0 && ReceivePush(PushKey, PushChannel, LocationPlace(Locations[Shown]), PUSH_LISTEN_TIME); // Also sets the time
+  BudgetDelay(Budget, millis() - Listen); // The WiFi deadline counts from when joining starts
+  if (Pushed) {
+    StoreLocation(Shown);
+    LocationRecords[Shown].Place = LocationPlace(Locations[Shown]);
+  }
+  bool WiFiUp = false;                              // Joined the access point, which a push doesn't need
+  bool Online = Pushed && SetupLocalTime() == true; // The clock is set
+  if (!Online && !BackoffActive()) {
+    uint8_t WiFiStatus = StartWiFi();
+    WiFiUp = WiFiStatus == WL_CONNECTED;
+    if (!WiFiUp) BackoffFailed(WiFiFailure(WiFiStatus), 0);
+    Online = WiFiUp && SetupClock() == true;
+  }
+  bool Network = WiFiUp && Online; // The forecast can be fetched, not only shown
+  if (Online || (time(NULL) > SCHEDULE_MIN_TIME && SetupLocalTime() == true)) { // Over budget, the RTC clock and the forecast kept will do
+    Serial.println(!Online ? "No WiFi or time, showing the forecast kept..." : Pushed ? "Forecast and Time received by ESP-NOW..." : "WiFi and Time services started...");
+    if (InSchedule(Schedule, ScheduleCount, time(NULL) - Stagger)) {
       //InitialiseDisplay(); // Give screen time to initialise by getting weather data!
-      byte Attempts = 1;
+      long MaxAge = esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TOUCHPAD ? 0 : SleepDuration * 60 - 60; // A touch asks for fresh data
       bool RxWeather = false;
-      WiFiClient client;   // wifi client object
-      while (RxWeather == false && Attempts <= 2) { // Try up-to 2 time for Weather
-        if (RxWeather  == false) RxWeather = ReceiveOneCallWeather(client, true); // true to print all the data results, false to not! 
-        Attempts++;
+      FetchDeadline  = Budget.Fetch;
+      bool Rendered  = Network && strlen(Renderer) > 0 && BudgetCheck(BUDGET_FETCH, Budget.Fetch) && ReceiveRendered(Shown);
+      if (Network && !Rendered && strlen(Gateway) > 0 && BudgetCheck(BUDGET_FETCH, Budget.Fetch) && !LocationFresh(Locations[Shown], Shown, MaxAge)) { // A LAN gateway has already fetched it
+        WiFiClient client;
+        RxWeather = ReceiveSnapshot(client, Gateway, Locations[Shown], Shown);
+      }
+      if (!Rendered && !RxWeather) { // true to print all the data results, false to not!
+        RxWeather = Network ? RefreshLocations(Locations, &Shown, 1, MaxAge, true) > 0 : LocationFresh(Locations[Shown], Shown, LOCATION_MAX_STALE);
+      }
+      BudgetCheck(BUDGET_FETCH, Budget.Fetch);
+      Stale = RxWeather && !LocationFresh(Locations[Shown], Shown, SleepDuration * 60); // Older than an update interval, e.g. the fetch was cut short
+      if (Network) { // A failed fetch delays the next, see backoff.h
+        if (Rendered || (RxWeather && !Stale)) BackoffSucceeded();
+        else if (FetchFailCode != 0) BackoffFailed(FetchFailure(FetchFailCode), FetchRetryAfter);
       }
-      if (RxWeather) { // Only if received Weather
+      BudgetRecord(Rendered || (RxWeather && !Stale) ? BUDGET_FRESH : RxWeather ? BUDGET_STALE : BUDGET_SKIPPED);
+      if (Rendered) {
+        StopWiFi();
+        RefreshDisplay();
+        TouchView = 0;
+      }
+      else if (RxWeather) { // Only if received Weather, now or on an earlier wake
         StopWiFi(); // Reduces power consumption
+        CpuWorkBegin();
+        LoadLocation(Shown);
+        LocationName = Locations[Shown].Name;
+        if (Stale) Time_str = FetchedTime(Shown);
         DisplayWeather();
-        display.display(false); // Full screen update mode
+        CpuWorkEnd();
+        RefreshDisplay();
+        CadenceSleep = NextCadence(Cadence);
+        CadenceDisplayed();
+        TouchView = 0;
       }
     }
   }
+  else BudgetRecord(BUDGET_SKIPPED); // No clock, so nothing can be shown
   BeginSleep();
 }
 //#########################################################################################
-void loop() { // this will never run!
+void loop() { // this will never run, other than on a render server!
+#ifdef RENDER_SERVER
+  RenderServer.handleClient();
+#endif
+}
+//#########################################################################################
+void RefreshDisplay() {
+  int phase = PhaseBegin("Panel refresh");
+  display.display(false); // Full screen update mode, in light sleep while the panel is busy
+  PhaseEnd(phase);
+}
+//#########################################################################################
+void RefreshView() {
+  int phase = PhaseBegin("Panel partial refresh");
+  display.display(true); // Partial update mode, over the image already on the panel, fast on panels that support it
+  PhaseEnd(phase);
+}
+//#########################################################################################
+bool ShowTouchView() { // The next view of the location on the panel, from its record in RTC memory
+  int l = (LocationNext + LocationCount - 1) % LocationCount; // Shown last
+  if (time(NULL) < SCHEDULE_MIN_TIME || !LoadLocation(l) || !SetupLocalTime()) return false; // Needs a full wake
+  LocationName = Locations[l].Name;
+  Time_str  = FetchedTime(l);
+  TouchView = (TouchView + 1) % TOUCH_VIEWS;
+  ViewShown = true;
+  Serial.println("Touch view " + String(TouchView) + " of " + LocationName);
+  InitialiseDisplay();
+  CpuWorkBegin();
+  if      (TouchView == 1) DisplayHourlyView();
+  else if (TouchView == 2) DisplayDailyView();
+  else                     DisplayWeather();
+  CpuWorkEnd();
+  RefreshView();
+  return true;
+}
+//#########################################################################################
+String FetchedTime(int l) { // When the location's forecast was fetched, rather than now
+  time_t    fetched = LocationRecords[l].Fetched;
+  struct tm local;
+  char      updated[30];
+  localtime_r(&fetched, &local);
+  strftime(updated, sizeof(updated), Units == "M" ? "%H:%M:%S" : "%r", &local);
+  return String(TXT_UPDATED) + " " + updated;
 }
 //#########################################################################################
+bool ReceiveRendered(int l) { // Drawn by a render server, so only downloaded and shown
+  InitialiseDisplay();
+  WiFiClient client;
+  String uri = String(RENDER_PATH) + "?lat=" + Locations[l].Lat + "&lon=" + Locations[l].Lon + "&rssi=" + String(wifi_signal) + "&mv=" + String(BatteryVoltage * 1000, 0);
+  if (ReceiveBitmap(client, Renderer, uri, SCREEN_WIDTH, SCREEN_HEIGHT, DrawBitmapRow)) return true;
+  display.fillScreen(GxEPD_WHITE); // Clears any rows received, before drawing it here instead
+  return false;
+}
+//#########################################################################################
+void DrawBitmapRow(int y, const uint8_t* row, int width) {
+  display.drawBitmap(0, y, row, width, 1, GxEPD_WHITE, GxEPD_BLACK);
+}
+#ifdef RENDER_SERVER
+//#########################################################################################
+void StartRenderServer() {
+  while (StartWiFi() != WL_CONNECTED) delay(5000);
+  WiFi.setSleep(false); // Mains powered, so answer the panels without modem sleep latency
+  while (!SetupTime()) delay(5000);
+  InitialiseDisplay();
+  RenderServer.on(RENDER_PATH, HandleRender);
+  RenderServer.begin();
+  Serial.println("Rendering for panels on " + WiFi.localIP().toString() + ":" + String(RENDER_PORT));
+}
+//#########################################################################################
+void HandleRender() {
+  int l = 0;
+  while (l < LocationCount && !(Locations[l].Lat == RenderServer.arg("lat") && Locations[l].Lon == RenderServer.arg("lon"))) l++;
+  if (l == LocationCount) {
+    RenderServer.send(404, "text/plain", "Location not rendered");
+    return;
+  }
+  if (RefreshLocations(Locations, &l, 1, SleepDuration * 60 - 60, false) == 0) {
+    RenderServer.send(503, "text/plain", "No forecast yet");
+    return;
+  }
+  unsigned long start = millis();
+  LoadLocation(l);
+  LocationName = Locations[l].Name;
+  wifi_signal  = RenderServer.arg("rssi").toInt();  // The panel's, as shown on it
+  PanelVoltage = RenderServer.arg("mv").toInt() / 1000.0;
+  UpdateLocalTime();
+  display.fillScreen(GxEPD_WHITE);
+  DisplayWeather();
+  size_t   size;
+  uint8_t* bitmap = EncodeBitmap(display.getBuffer(), display.width(), display.height(), size);
+  if (bitmap == NULL) {
+    RenderServer.send(500, "text/plain", "Not enough memory");
+    return;
+  }
+  RenderServer.send_P(200, "application/octet-stream", (PGM_P)bitmap, size);
+  free(bitmap);
+  Serial.println("Rendered " + LocationName + " as " + String(size) + " bytes in " + String(millis() - start) + "-ms");
+}
+#endif
+//#########################################################################################
 /* List of Touch Pins and their names
 TOUCH0 (T0) – GPIO4
 TOUCH2 (T2) – GPIO2
@@ -155,11 +360,25 @@ void callback(){
 
 void BeginSleep() { // Wake up with a Touch pin to refresh the weather data, just needs a wire on the chosen pin
   display.powerOff();
-  long SleepTimer = (SleepDuration * 60 - ((CurrentMin % SleepDuration) * 60 + CurrentSec)); //Some ESP32 are too fast to maintain accurate time
+  PrintPhases();
+  PrintCpuClock();
+  PrintBudget();
+  time_t now  = time(NULL);
+  time_t slot = now - Stagger; // In the schedule's times, which this panel's updates are Stagger after
+  time_t wake = NextScheduledWake(Schedule, ScheduleCount, slot);
+  if (BatteryLevel >= BATTERY_SAVING) CadenceSleep = max(CadenceSleep, (long)Cadence.MaxSleep); // Fewer refreshes on a low battery
+  time_t later;
+  while (wake > 0 && (later = NextScheduledWake(Schedule, ScheduleCount, wake)) > 0 && later - slot <= CadenceSleep * 60 + 60) wake = later; // Skips updates while the weather is settled
+  while (wake > 0 && wake + Stagger < (time_t)BackoffUntil) wake = NextScheduledWake(Schedule, ScheduleCount, wake); // Sleeps through the wakes that would only back off
+  if (wake > 0) wake += Stagger;
+  if (ViewShown && NextWake > now) wake = NextWake; // A touch view doesn't move the next update
+  NextWake = wake;
+  long SleepTimer = wake > 0 ? wake - now : (SleepDuration * 60 - ((CurrentMin % SleepDuration) * 60 + CurrentSec)); // Unscheduled if the time isn't known
   int Threshold = 50;  // The higher the number, the more sensitive the touch function
   touchAttachInterrupt(T3, callback, Threshold); // T3 is Touch-3 and is GPIO-15 see list
   esp_sleep_enable_touchpad_wakeup();
-  esp_sleep_enable_timer_wakeup((SleepTimer+20) * 1000000LL); // Added +20 seconds to cover ESP32 RTC timer source inaccuracies
+  if (BatteryLevel != BATTERY_EMPTY) esp_sleep_enable_timer_wakeup((SleepTimer+20) * 1000000LL); // Added +20 seconds to cover ESP32 RTC timer source inaccuracies
+  else Serial.println("Battery empty, sleeping until touched or reset");
 #ifdef BUILTIN_LED
   pinMode(BUILTIN_LED, INPUT); // If it's On, turn it off and some boards use GPIO-5 for SPI-SS, which remains low after screen use
   digitalWrite(BUILTIN_LED, HIGH);
@@ -182,11 +401,16 @@ void DisplayWeather() {                        // 7.5" e-paper display is 640x38
 void DisplayGeneralInfoSection() {
   u8g2Fonts.setFont(u8g2_font_helvB08_tf);
   drawString(5, 2, "[Version: " + version + "]", LEFT); // Programme version
-  drawString(SCREEN_WIDTH / 2, 3, City, CENTER);
+  drawString(SCREEN_WIDTH / 2, 3, LocationName, CENTER);
   u8g2Fonts.setFont(u8g2_font_helvB14_tf);
   drawString(421, 155, Date_str, CENTER);
   u8g2Fonts.setFont(u8g2_font_helvB10_tf);
+  if (Stale) { // Shown inverted, as the forecast is from an earlier wake
+    display.fillRect(421 - 80, 177, 160, 19, GxEPD_BLACK);
+    u8g2Fonts.setForegroundColor(GxEPD_WHITE);
+  }
   drawString(421, 180, Time_str, CENTER);
+  u8g2Fonts.setForegroundColor(GxEPD_BLACK);
   display.drawLine(0, 15, SCREEN_WIDTH - 4, 15, GxEPD_BLACK);
 }
 //#########################################################################################
@@ -403,16 +627,8 @@ void DisplayForecastSection(int x, int y) {
     DisplayForecastWeather(x, y, f);
     f++;
   } while (f <= 7);
-  // Pre-load temporary arrays with with data - because C parses by reference
-  int r = 0;
-  do {
-    if (Units == "I") pressure_readings[r] = WxForecast[r].Pressure * 0.02953;   else pressure_readings[r] = WxForecast[r].Pressure;
-    if (Units == "I") rain_readings[r]     = WxForecast[r].Rainfall * 0.0393701; else rain_readings[r]     = WxForecast[r].Rainfall;
-    if (Units == "I") snow_readings[r]     = WxForecast[r].Snowfall * 0.0393701; else snow_readings[r]     = WxForecast[r].Snowfall;
-    temperature_readings[r] = WxForecast[r].Temperature;
-    humidity_readings[r]    = WxForecast[r].Humidity;
-    r++;
-  } while (r < max_readings);
+  if (BatteryLevel >= BATTERY_NO_GRAPHS) return; // Less to draw on a low battery
+  LoadReadings();
   int gwidth = 120, gheight = 58;
   int gx = (SCREEN_WIDTH - gwidth * 4) / 5 + 5;
   int gy = 300;
@@ -431,6 +647,65 @@ void DisplayForecastSection(int x, int y) {
   else DrawGraph(gx + 3 * gap + 5, gy, gwidth, gheight, 0, 30, Units == "M" ? TXT_SNOWFALL_MM : TXT_SNOWFALL_IN, snow_readings, Snow_array_size, autoscale_on, barchart_on);
 }
 //#########################################################################################
+void LoadReadings() {
+  // Pre-load temporary arrays with with data - because C parses by reference
+  int r = 0;
+  do {
+    if (Units == "I") pressure_readings[r] = WxForecast[r].Pressure * 0.02953;   else pressure_readings[r] = WxForecast[r].Pressure;
+    if (Units == "I") rain_readings[r]     = WxForecast[r].Rainfall * 0.0393701; else rain_readings[r]     = WxForecast[r].Rainfall;
+    if (Units == "I") snow_readings[r]     = WxForecast[r].Snowfall * 0.0393701; else snow_readings[r]     = WxForecast[r].Snowfall;
+    temperature_readings[r] = WxForecast[r].Temperature;
+    humidity_readings[r]    = WxForecast[r].Humidity;
+    pop_readings[r]         = WxForecast[r].PoP * 100;
+    r++;
+  } while (r < max_readings);
+}
+//#########################################################################################
+void DisplayViewHeader() { // Top line of a touch view
+  u8g2Fonts.setFont(u8g2_font_helvB08_tf);
+  drawString(5, 2, Date_str, LEFT);
+  drawString(SCREEN_WIDTH / 2, 3, LocationName, CENTER);
+  drawString(SCREEN_WIDTH - 8, 2, Time_str, RIGHT);
+  display.drawLine(0, 15, SCREEN_WIDTH - 4, 15, GxEPD_BLACK);
+}
+//#########################################################################################
+void DisplayHourlyView() { // The hourly forecast graphs, larger than on the forecast display
+  DisplayViewHeader();
+  LoadReadings();
+  int gwidth = 240, gheight = 110;
+  int gx[] = {60, 370}, gy[] = {55, 230};
+  u8g2Fonts.setFont(u8g2_font_helvB08_tf);
+  DrawGraph(gx[0], gy[0], gwidth, gheight, 10, 30, Units == "M" ? TXT_TEMPERATURE_C : TXT_TEMPERATURE_F, temperature_readings, max_readings, autoscale_on, barchart_off);
+  DrawGraph(gx[1], gy[0], gwidth, gheight, 900, 1050, Units == "M" ? TXT_PRESSURE_HPA : TXT_PRESSURE_IN, pressure_readings, max_readings, autoscale_on, barchart_off);
+  DrawGraph(gx[0], gy[1], gwidth, gheight, 0, 100, TXT_PRECIPITATION_SOON + String(" (%)"), pop_readings, max_readings, autoscale_off, barchart_on);
+  const int Rain_array_size = sizeof(rain_readings) / sizeof(float);
+  const int Snow_array_size = sizeof(snow_readings) / sizeof(float);
+  if (SumOfPrecip(rain_readings, Rain_array_size) >= SumOfPrecip(snow_readings, Snow_array_size))
+    DrawGraph(gx[1], gy[1], gwidth, gheight, 0, 30, Units == "M" ? TXT_RAINFALL_MM : TXT_RAINFALL_IN, rain_readings, Rain_array_size, autoscale_on, barchart_on);
+  else DrawGraph(gx[1], gy[1], gwidth, gheight, 0, 30, Units == "M" ? TXT_SNOWFALL_MM : TXT_SNOWFALL_IN, snow_readings, Snow_array_size, autoscale_on, barchart_on);
+}
+//#########################################################################################
+void DisplayDailyView() { // The 8-day forecast, a column a day
+  DisplayViewHeader();
+  int fwidth = SCREEN_WIDTH / 8;
+  for (int d = 0; d < 8; d++) {
+    int x = d * fwidth;
+    time_t    day = Daily[d].Dt + WxConditions[0].Timezone;
+    struct tm date;
+    gmtime_r(&day, &date);
+    display.drawRect(x + 2, 30, fwidth - 4, 330, GxEPD_BLACK);
+    u8g2Fonts.setFont(u8g2_font_helvB14_tf);
+    drawString(x + fwidth / 2, 40, weekday_D[date.tm_wday], CENTER);
+    u8g2Fonts.setFont(u8g2_font_helvB08_tf);
+    drawString(x + fwidth / 2, 65, String(date.tm_mday) + " " + month_M[date.tm_mon], CENTER);
+    DisplayConditionsSection(x + fwidth / 2, 140, Daily[d].Icon, SmallIcon);
+    u8g2Fonts.setFont(u8g2_font_helvB18_tf);
+    drawString(x + fwidth / 2, 230, String(Daily[d].High, 0) + "°", CENTER);
+    u8g2Fonts.setFont(u8g2_font_helvB14_tf);
+    drawString(x + fwidth / 2, 280, String(Daily[d].Low, 0) + "°", CENTER);
+  }
+}
+//#########################################################################################
 void DisplayConditionsSection(int x, int y, String IconName, bool IconSize) {
   Serial.println("Icon name: " + IconName);
   if      (IconName == "01d" || IconName == "01n")  Sunny(x, y, IconSize, IconName);
@@ -484,7 +759,11 @@ uint8_t StartWiFi() {
   bool AttemptConnection = true;
   while (AttemptConnection) {
     connectionStatus = WiFi.status();
+#ifdef RENDER_SERVER
     if (millis() > start + 15000) { // Wait 15-secs maximum
+#else
+    if (!BudgetCheck(BUDGET_WIFI, Budget.WiFi)) { // Joined within the wake budget
+#endif
       AttemptConnection = false;
     }
     if (connectionStatus == WL_CONNECTED || connectionStatus == WL_CONNECT_FAILED) {
@@ -541,10 +820,24 @@ boolean SetupTime() {
   return TimeStatus;
 }
 //#########################################################################################
+boolean SetupClock() { // NTP, unless the battery is low and the RTC has kept the time since it was last set
+  if (BatteryLevel >= BATTERY_NO_NTP && time(NULL) > SCHEDULE_MIN_TIME) return SetupLocalTime();
+  ClockWait = BudgetLeft(Budget.Clock);
+  if (SetupTime()) return true;
+  BudgetCheck(BUDGET_CLOCK, Budget.Clock);
+  return false;
+}
+//#########################################################################################
+boolean SetupLocalTime() { // The clock is already set, e.g. by an ESP-NOW push, so only the time zone is needed
+  setenv("TZ", Timezone, 1);
+  tzset();
+  return UpdateLocalTime();
+}
+//#########################################################################################
 boolean UpdateLocalTime() {
   struct tm timeinfo;
   char   time_output[30], day_output[30], update_time[30];
-  while (!getLocalTime(&timeinfo, 10000)) { // Wait for 10-sec for time to synchronise
+  while (!getLocalTime(&timeinfo, ClockWait)) { // Wait for 10-sec, or to the clock's deadline, for time to synchronise
     Serial.println("Failed to obtain time");
     return false;
   }
@@ -577,12 +870,9 @@ boolean UpdateLocalTime() {
 //#########################################################################################
 void DrawBattery(int x, int y) {
   uint8_t percentage = 100;
-  float voltage = analogRead(35) / 4096.0 * 7.46;
+  float voltage = PanelVoltage >= 0 ? PanelVoltage : BatteryVoltage; // Read by CheckBattery() on waking
   if (voltage > 1 ) { // Only display if there is a valid reading
-    Serial.println("Voltage = " + String(voltage));
-    percentage = 2836.9625 * pow(voltage, 4) - 43987.4889 * pow(voltage, 3) + 255233.8134 * pow(voltage, 2) - 656689.7123 * voltage + 632041.7303;
-    if (voltage >= 4.20) percentage = 100;
-    if (voltage <= 3.50) percentage = 0;
+    percentage = BatteryPercent(voltage);
     display.drawRect(x + 15, y - 12, 19, 10, GxEPD_BLACK);
     display.fillRect(x + 34, y - 10, 2, 5, GxEPD_BLACK);
     display.fillRect(x + 17, y - 10, 15 * percentage / 100.0, 6, GxEPD_BLACK);
@@ -591,6 +881,20 @@ void DrawBattery(int x, int y) {
   }
 }
 //#########################################################################################
+void DisplayLowBattery() { // The last frame before the battery runs out, which the panel keeps with no power
+  InitialiseDisplay();
+  int x = SCREEN_WIDTH / 2, y = SCREEN_HEIGHT / 2;
+  display.drawRect(x - 100, y - 50, 190, 100, GxEPD_BLACK);
+  display.drawRect(x - 99, y - 49, 188, 98, GxEPD_BLACK);
+  display.fillRect(x + 90, y - 20, 12, 40, GxEPD_BLACK);
+  display.fillRect(x - 94, y - 44, 10, 88, GxEPD_BLACK); // All but empty
+  u8g2Fonts.setFont(u8g2_font_helvB24_tf);
+  drawString(x, y - 12, String(BatteryVoltage, 2) + "v", CENTER);
+  u8g2Fonts.setFont(u8g2_font_helvB10_tf);
+  if (time(NULL) > SCHEDULE_MIN_TIME && SetupLocalTime()) drawString(x, y + 65, Date_str + "  " + Time_str, CENTER);
+  RefreshDisplay();
+}
+//#########################################################################################
 // Symbols are drawn on a relative 10x10grid and 1 scale unit = 1 drawing unit
 void addcloud(int x, int y, int scale, int linesize) {
   //Draw cloud outer
@@ -966,8 +1270,11 @@ void drawStringMaxWidth(int x, int y, unsigned int text_width, String text, alig
 }
 //#########################################################################################
 void InitialiseDisplay() {
-  display.init(115200, true, 2, false);
+  display.init(115200, !ViewShown, 2, false); // A touch view updates the image already on the panel
   // display.init(); for older Waveshare HAT's
+#ifndef RENDER_SERVER
+  display.epd2.setBusyCallback(BusyLightSleep, &EPD_BUSY); // See busy_sleep.h
+#endif
   SPI.end();
   SPI.begin(EPD_SCK, EPD_MISO, EPD_MOSI, EPD_CS);
   u8g2Fonts.begin(display); // connect u8g2 procedures to Adafruit GFX
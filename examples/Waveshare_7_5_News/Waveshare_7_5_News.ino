@@ -72,7 +72,7 @@ U8G2_FOR_ADAFRUIT_GFX u8g2Fonts;  // Select u8g2 font from here: https://github.
 // u8g2_font_helvB24_tf
 
 //################  VERSION  ###########################################
-String version = "16.12";     // Programme version, see change log at end
+String version = "16.15";     // Programme version, see change log at end
 //################ VARIABLES ###########################################
 
 boolean LargeIcon = true, SmallIcon = false;
@@ -84,15 +84,19 @@ long    StartTime = 0;
 
 //################ PROGRAM VARIABLES and OBJECTS ################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
+String NewsUri();
 
 #define max_readings 24
 
+#define  OWM_PORT 443                  // Fetch over HTTPS
+#define  FETCH_TLS                     // and so have http_fetch.h include tls_client.h
 #include "common.h"
+#include "http_fetch.h"
+#include "news.h"
+#include "wake_stub.h"
 
 // News Client variables
-int    newsIndex  = 0;
-String NewsItem[11];
 String TopNews = "";
 
 #define autoscale_on  true
@@ -114,17 +118,26 @@ int  SleepTime     = 23; // Sleep after (23+1) 00:00 to save battery power
 void setup() {
   StartTime = millis();
   Serial.begin(115200);
+  PrintQuietWakes();
   if (StartWiFi() == WL_CONNECTED && SetupTime() == true) {
     if ((CurrentHour >= WakeupTime && CurrentHour <= SleepTime)) {
       InitialiseDisplay(); // Give screen time to initialise by getting weather data!
-      byte Attempts = 1;
-      bool RxWeather = false;
-      WiFiClient client;   // wifi client object
-      while (RxWeather == false && Attempts <= 2) { // Try up-to 2 time for Weather and Forecast data
-        if (RxWeather   == false) RxWeather  = ReceiveOneCallWeather(client, true);
-        Attempts++;
+      if (strlen(OwmFingerprint))  SetTlsPin(server, OwmFingerprint);
+      if (strlen(NewsFingerprint)) SetTlsPin(NewsServer.c_str(), NewsFingerprint);
+      Fetch_job_type Jobs[2];
+      Jobs[0] = FetchJob(server, OWM_PORT, OneCallUri(), DecodeOneCallWeather, true); // Weather and News are on different hosts, so fetched concurrently
+      Jobs[1] = FetchJob(NewsServer, 443, NewsUri(), DecodeNewsHeadlines, false);
+#if defined(ONECALL_BUFFERED_DECODE) && !defined(ONECALL_STREAM_PARSER)
+      Jobs[0].Fallback = DecodeOneCallStreamed; // Weather body is kept, so a failed decode is retried without a refetch
+#endif
+      RunFetchJobs(Jobs, 2);
+      bool RxWeather = Jobs[0].Decoded;
+      if (RxWeather == false) { // Try a second time for Weather and Forecast data
+        TlsClient client;    // HTTPS client object
+        client.SetHostname(server);
+        RxWeather = ReceiveOneCallWeather(client, true);
       }
-      GetNews();
+      if (HeadlineCount > 0) TopNews = Headlines[0].Title;
       if (RxWeather) { // Only if received both Weather or Forecast proceed
         StopWiFi(); // Reduces power consumption
         DisplayWeather();
@@ -143,11 +156,14 @@ void BeginSleep() {
   display.powerOff();
   long SleepTimer = (SleepDuration * 60 - ((CurrentMin % SleepDuration) * 60 + CurrentSec)); //Some ESP32 are too fast to maintain accurate time
   esp_sleep_enable_timer_wakeup((SleepTimer + 20) * 1000000LL); // Added +20 seconnds to cover ESP32 RTC timer source inaccuracies
+  QuietWakes  = QuietWakesBefore(WakeupTime, SleepTime, SleepTimer + 20, SleepDuration * 60); // Slept through by the wake stub
+  QuietPeriod = SleepDuration * 60 * 1000000ULL;
 #ifdef BUILTIN_LED
   pinMode(BUILTIN_LED, INPUT); // If it's On, turn it off and some boards use GPIO-5 for SPI-SS, which remains low after screen use
   digitalWrite(BUILTIN_LED, HIGH);
 #endif
   Serial.println("Entering " + String(SleepTimer) + "-secs of sleep time");
+  PrintPhases();
   Serial.println("Awake for : " + String((millis() - StartTime) / 1000.0, 3) + "-secs");
   Serial.println("Starting deep-sleep period...");
   esp_deep_sleep_start();      // Sleep for e.g. 30 minutes
@@ -165,9 +181,11 @@ void DisplayWeather() {                        // 7.5" e-paper display is 640x38
 void DisplayNews() {
   u8g2Fonts.setFont(u8g2_font_helvB08_tf);
   // Only displays the first / most recent news item
-  drawString(0, 20, NewsSource + ": " + NewsItem[0], LEFT); // Top news item
-  for (int i = 0; i < 10; i++) {
-    Serial.println(String(i + 1) + " : " + NewsItem[i]);
+  if (HeadlineCount == 0) return;
+  String source = strlen(Headlines[0].Source) > 0 ? String(Headlines[0].Source) : NewsSource;
+  drawString(0, 20, source + ": " + TopNews, LEFT); // Top news item
+  for (int i = 0; i < HeadlineCount; i++) {
+    Serial.println(String(i + 1) + " : " + String(Headlines[i].Title));
   }
 }
 //#########################################################################################
@@ -449,58 +467,8 @@ void DisplayConditionsSection(int x, int y, String IconName, bool IconSize) {
   }
 }
 //#########################################################################################
-bool GetNews() {
-  HTTPClient http;
-  WiFiClient client; // Needs a new instance?
-  String apiGetData = "http://" + NewsServer + "/v2/top-headlines?sources=" + NewsSource + "&apiKey=" + NewsApiKey;
-  //Serial.println("Getting News Data");
-  //Serial.println(apiGetData);
-  http.begin(client, apiGetData);
-  int httpCode = http.GET();
-  if (httpCode > 0) {  // checks for connection
-    //Serial.printf("[HTTP] GET... code: %d\n", httpCode);
-    ReadNews(http.getStream());
-    TopNews = NewsItem[0];
-    for (int index = 0; index < 10; index++) {
-      //Serial.println(String(index + 1) + ". " + NewsItem[index]);
-    }
-    client.stop();
-    http.end();
-    return true;
-  }
-  else
-  {
-    Serial.printf("News Data Connection Error: %s\n", http.errorToString(httpCode).c_str());
-    client.stop();
-    http.end();
-    return false;
-  }
-}
-//#########################################################################################
-void ReadNews(WiFiClient& json_input) {
-  DynamicJsonDocument doc(10 * 1024);
-  DeserializationError error = deserializeJson(doc, json_input);
-  if (error) {
-    Serial.print(F("deserialiseJson() failed: "));
-    Serial.println(error.f_str());
-    return;
-  }
-  const char* status = doc["status"]; // "ok"
-  int totalResults = doc["totalResults"]; // 10
-  int arrayindex   = 0;
-  for (JsonObject articles_item : doc["articles"].as<JsonArray>()) {
-    const char* articles_item_source_id   = articles_item["source"]["id"];   // "bbc-news", "bbc-news", ...
-    const char* articles_item_source_name = articles_item["source"]["name"]; // "BBC News", "BBC News", "BBC ...
-    const char* articles_item_author      = articles_item["author"];         // "BBC Sport", "BBC News", "BBC News", "BBC ...
-    const char* articles_item_title       = articles_item["title"];          // "Peng 'must be heard' on sex abuse claim", ...
-    NewsItem[arrayindex] = String(articles_item_title);
-    arrayindex++;
-    const char* articles_item_description = articles_item["description"];    // "Chinese player Peng Shuai ...
-    const char* articles_item_url         = articles_item["url"];            // "http://www.bbc.co.uk/sport/tennis/59284680", ...
-    const char* articles_item_urlToImage  = articles_item["urlToImage"];
-    const char* articles_item_publishedAt = articles_item["publishedAt"];    // "2021-11-14T19:07:28.7525381Z", ...
-    const char* articles_item_content     = articles_item["content"];        // "Peng Shuai is a former world number ...
-  }
+String NewsUri() {
+  return "/v2/top-headlines?sources=" + NewsSource + "&apiKey=" + NewsApiKey;
 }
 //#########################################################################################
 void arrow(int x, int y, int asize, float aangle, int pwidth, int plength) {
@@ -1104,5 +1072,17 @@ void InitialiseDisplay() {
 
   Version 16.12
    1. Added News reader and display
+
+  Version 16.13
+   1. Weather and News are fetched concurrently, each host over a single persistent connection
+   2. News decoding keeps only headline titles and sources, in a fixed size buffer
+
+  Version 16.14
+   1. Weather and News are fetched over HTTPS, with optional certificate pinning (see owm_credentials.h)
+   2. TLS sessions are kept during deep-sleep, so most wakes resume them instead of a full handshake
+   3. Time taken by each phase of the wake e.g. TCP connect and TLS handshake is reported before sleeping
+
+  Version 16.15
+   1. Server addresses are kept during deep-sleep for as long as DNS allows, so most wakes connect without a DNS lookup
 */
 
@@ -14,6 +14,12 @@ String NewsServer = "newsapi.org";
 String NewsSource = "bbc-news";  // https://newsapi.org/sources forfull list of news sources available
 String NewsApiKey = "your News API key";
 
+// Both servers are fetched over HTTPS. Pin each server's certificate by entering its SHA-256 fingerprint, the
+// fingerprint is printed on the serial port while no pin is set. A server with no pin is refused, so the API keys are
+// never sent to a server that hasn't been authenticated.
+const char* OwmFingerprint  = "";
+const char* NewsFingerprint = "";
+
 String LAT              = "51.38";                         // Home location Latitude
 String LON              = "-2.36";                         // Home location Longitude
 
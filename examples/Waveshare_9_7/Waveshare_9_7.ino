@@ -78,7 +78,16 @@ static const uint8_t EPD_MOSI = 23; // to EPD DIN
 //static const uint8_t EPD_MISO = 12; // Master-In Slave-Out not used, as no data from display
 //static const uint8_t EPD_MOSI = 14;
 
+//#define RENDER_SERVER // Build to draw this display for other 9.7" panels, which then only download it (see bitmap_codec.h)
+// The render server is this sketch on a second, mains powered ESP32 with PSRAM, e.g. a WROVER, as the 1200x825 canvas
+// it draws into is 124k. It serves the drawing on RENDER_PORT at RENDER_PATH, for panels with Renderer set.
+#ifdef RENDER_SERVER
+#include <WebServer.h>
+#include "frame_canvas.h"
+FrameCanvas display(SCREEN_WIDTH, SCREEN_HEIGHT);
+#else
 GxEPD2_BW<GxEPD2_it60, GxEPD2_it60::HEIGHT / 2> display(GxEPD2_it60(/*CS=*/ EPD_CS, /*DC=*/ EPD_DC, /*RST=*/ EPD_RST, /*BUSY=*/ EPD_BUSY));   // B/W display
+#endif
 //  GxEPD2_BW<GxEPD2_750_T7, GxEPD2_750_T7::HEIGHT> display(GxEPD2_750_T7(/*CS=*/ EPD_CS, /*DC=*/ EPD_DC, /*RST=*/ EPD_RST, /*BUSY=*/ EPD_BUSY));   // B/W display
 //GxEPD2_3C<GxEPD2_750c, GxEPD2_750c::HEIGHT> display(GxEPD2_750(/*CS=*/ EPD_CS, /*DC=*/ EPD_DC, /*RST=*/ EPD_RST, /*BUSY=*/ EPD_BUSY)); // 3-colour displays
 // use GxEPD_BLACK or GxEPD_WHITE or GxEPD_RED or GxEPD_YELLOW depending on display type
@@ -96,7 +105,7 @@ U8G2_FOR_ADAFRUIT_GFX u8g2Fonts;  // Select u8g2 font from here: https://github.
 
 
 //################  VERSION  ##################################################
-String version = "1.2 / 9.7in";     // Programme version, see change log at end
+String version = "1.3 / 9.7in";     // Programme version, see change log at end
 //################ VARIABLES ##################################################
 
 boolean LargeIcon = true, SmallIcon = false;
@@ -111,11 +120,16 @@ int        wifi_signal, CurrentHour = 0, CurrentMin = 0, CurrentSec = 0, EventCn
 
 //################ PROGRAM VARIABLES and OBJECTS ################
 bool ReceiveOneCallWeather(WiFiClient& json, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
 
 #define max_readings 24
 
 #include "common.h"
+#include "battery.h"
+#include "bitmap_codec.h"
+#include "busy_sleep.h"
+#include "schedule.h"
+#include "stagger.h"
 #include <rom/rtc.h>
 #include "soc/soc.h"
 #include "soc/rtc_cntl_reg.h"
@@ -134,34 +148,58 @@ float snow_readings[max_readings]        = {0};
 long SleepDuration = 30; // Sleep time in minutes, aligned to the nearest minute boundary, so if 30 will always update at 00 or 30 past the hour
 int  WakeupTime    = 7;  // Don't wakeup until after 07:00 to save battery power
 int  SleepTime     = 23; // Sleep after (23+1) 00:00 to save battery power
+Schedule_rule_type Schedule[] = { // When to update the display, see schedule.h e.g. {SCHEDULE_WEEKDAYS, 7 * 60, 18 * 60, 15},
+  {SCHEDULE_EVERY_DAY, WakeupTime * 60, (SleepTime + 1) * 60, (int)SleepDuration},
+};
+const int ScheduleCount = sizeof(Schedule) / sizeof(Schedule[0]);
+long     StaggerSpread = SleepDuration * 60; // secs a fleet's updates are spread over, 0 for none, see stagger.h
+uint32_t Stagger       = 0;                  // secs this panel's updates are after the scheduled times
 long StartTime = 0, SleepTimer = 0;
 long Delta         = 12; // correction factor to compensate the ESP32 speed
 // Prevents display at xx:59:yy and then xx:00:yy (one minute later) to save power
 String LocalIP;
+float  PanelVoltage = -1; // Battery voltage sent by a panel to a render server, which has no battery of its own
+#ifdef RENDER_SERVER
+WebServer RenderServer(RENDER_PORT);
+time_t    Fetched = 0;    // When the forecast drawn was received
+#endif
 
 //#########################################################################################
 void setup() {
   StartTime = millis();
+#ifdef RENDER_SERVER
+  Serial.begin(115200);
+  StartRenderServer();
+  return;
+#endif
   DisableBrownOutDetector();
   VerboseRecordOfResetReason(rtc_get_reset_reason(0)); // 0 means CPU0 (Main core)
   delay(500); // Allow the PSU to stabilise
 
   Serial.begin(115200);
+  Stagger = StaggerOffset(StaggerSpread);
 
   // Early initilisation of the display to be able to display the EventLog in case of a WiFi problem
   InitialiseDisplay(); // Give screen time to initialise by getting weather data!
 
   if (StartWiFi() == WL_CONNECTED && SetupTime() == true) {
-    if ((CurrentHour >= WakeupTime && CurrentHour <= SleepTime)) {
+    if (InSchedule(Schedule, ScheduleCount, time(NULL) - Stagger)) {
       //khl moved to above;     InitialiseDisplay(); // Give screen time to initialise by getting weather data!
       byte Attempts = 1;
+      bool Rendered  = strlen(Renderer) > 0 && ReceiveRendered();
       bool RxWeather = false;
       WiFiClient client;   // wifi client object
-      while (RxWeather == false) && Attempts <= 2) { // Try up-to 2 time for Weather and Forecast data
+      while (!Rendered && RxWeather == false && Attempts <= 2) { // Try up-to 2 time for Weather and Forecast data
+        if (Attempts > 1) delay(esp_random() % 500); // So panels that failed together retry apart
         if (RxWeather  == false) RxWeather  = ReceiveOneCallWeather(client, true);
         Attempts++;
       }
-      if (RxWeather) { // Only if received both Weather or Forecast proceed
+      int phase = PhaseBegin("Panel refresh");
+      if (Rendered) {
+        StopWiFi();
+        display.refresh(false); // Full update from what's already in the controller's memory
+      }
+      else if (RxWeather) { // Only if received both Weather or Forecast proceed
         StopWiFi(); // Reduces power consumption
         DisplayWeather();
       }
@@ -169,6 +207,7 @@ void setup() {
       {
         if (!RxWeather)  AddToEventLog("*** Failed to Rx Weather data ***");
       }
+      PhaseEnd(phase);
     }
   }
 
@@ -177,17 +216,22 @@ void setup() {
     StopWiFi(); // Reduces power consumption
   }
 
-  if ((CurrentHour == SleepTime)) {
-    Serial.println("Sleeping for 3600 * WakeupTime seconds....");
-    SleepTimer = WakeupTime * 3600;
+  time_t now  = time(NULL);
+  time_t wake = NextScheduledWake(Schedule, ScheduleCount, now - Stagger); // Then Stagger after it, see stagger.h
+  if (wake > 0) {
+    Serial.println("Sleeping until the next scheduled update....");
+    SleepTimer = wake + Stagger - now + Delta;
   }
-  else {
+  else { // The time isn't known
     SleepTimer = (SleepDuration * 60 - ((CurrentMin % SleepDuration) * 60 + CurrentSec - Delta)); //Some ESP32 are too fast to maintain accurate time
   }
   BeginSleep();
 }
 //#########################################################################################
-void loop() { // this will never run!
+void loop() { // this will never run, other than on a render server!
+#ifdef RENDER_SERVER
+  RenderServer.handleClient();
+#endif
 }
 //#########################################################################################
 void BeginSleep() {
@@ -207,6 +251,7 @@ void BeginSleep() {
   delay(500);
   //  display.powerOff();
   display.hibernate();     // Hibernate instead of powerOff
+  PrintPhases();
 
   esp_sleep_enable_timer_wakeup(SleepTimer * 1000000LL);
 
@@ -238,6 +283,61 @@ void DisplayWeather() {                          // 9.7" e-paper display is 1200
   while (display.nextPage());
 }
 //#########################################################################################
+// Drawn by a render server, so only downloaded and written into the controller a band at a time, as there's
+// no room for a frame buffer of this display. Drawn here instead if it fails, which overwrites any bands written.
+bool ReceiveRendered() {
+  WiFiClient client;
+  String uri = String(RENDER_PATH) + "?lat=" + LAT + "&lon=" + LON + "&rssi=" + String(wifi_signal) + "&mv=" + String(ReadBattery(1.0) * 1000, 0);
+  return ReceiveBitmapBands(client, Renderer, uri, SCREEN_WIDTH, SCREEN_HEIGHT, WriteBitmapBand);
+}
+//#########################################################################################
+void WriteBitmapBand(int y, const uint8_t* band, int width, int rows) {
+  display.writeImage(band, 0, y, width, rows); // 1 is white, as in the bitmap
+}
+#ifdef RENDER_SERVER
+//#########################################################################################
+void StartRenderServer() {
+  while (StartWiFi() != WL_CONNECTED) delay(5000);
+  WiFi.setSleep(false); // Mains powered, so answer the panels without modem sleep latency
+  while (!SetupTime()) delay(5000);
+  InitialiseDisplay();
+  if (display.getBuffer() == NULL) Serial.println("*** No memory for the canvas, this needs a board with PSRAM ***");
+  RenderServer.on(RENDER_PATH, HandleRender);
+  RenderServer.begin();
+  Serial.println("Rendering for panels on " + WiFi.localIP().toString() + ":" + String(RENDER_PORT));
+}
+//#########################################################################################
+void HandleRender() {
+  if (RenderServer.arg("lat") != LAT || RenderServer.arg("lon") != LON) {
+    RenderServer.send(404, "text/plain", "Location not rendered");
+    return;
+  }
+  if (time(NULL) - Fetched > SleepDuration * 60 - 60) { // At most once for each of the panels' updates
+    WiFiClient client;
+    if (ReceiveOneCallWeather(client, false)) Fetched = time(NULL);
+    else if (Fetched == 0) {
+      RenderServer.send(503, "text/plain", "No forecast yet");
+      return;
+    }
+  }
+  unsigned long start = millis();
+  wifi_signal  = RenderServer.arg("rssi").toInt(); // The panel's, as shown on it
+  PanelVoltage = RenderServer.arg("mv").toInt() / 1000.0;
+  UpdateLocalTime();
+  display.fillScreen(GxEPD_WHITE);
+  DisplayWeather();
+  size_t   size;
+  uint8_t* bitmap = display.getBuffer() ? EncodeBitmap(display.getBuffer(), display.width(), display.height(), size) : NULL;
+  if (bitmap == NULL) {
+    RenderServer.send(500, "text/plain", "Not enough memory");
+    return;
+  }
+  RenderServer.send_P(200, "application/octet-stream", (PGM_P)bitmap, size);
+  free(bitmap);
+  Serial.println("Rendered as " + String(size) + " bytes in " + String(millis() - start) + "-ms");
+}
+#endif
+//#########################################################################################
 void DisplayGeneralInfoSection() {
   u8g2Fonts.setFont(u8g2_font_helvB14_tf);
   drawString(12, 20, "[Version: " + version + "]", LEFT); // Programme version
@@ -665,7 +765,7 @@ boolean UpdateLocalTime() {
 //#########################################################################################
 void DrawBattery(int x, int y) {
   uint8_t percentage = 100;
-  float voltage = analogRead(35) / 4096.0 * 7.46;
+  float voltage = PanelVoltage >= 0 ? PanelVoltage : ReadBattery(1.0);
   if (voltage > 1 ) { // Only display if there is a valid reading
     Serial.println("Voltage = " + String(voltage));
     percentage = 2836.9625 * pow(voltage, 4) - 43987.4889 * pow(voltage, 3) + 255233.8134 * pow(voltage, 2) - 656689.7123 * voltage + 632041.7303;
@@ -1061,6 +1161,9 @@ void drawStringMaxWidth(int x, int y, unsigned int text_width, String text, alig
 void InitialiseDisplay() {
   display.init(115200, true, 2, false);
   // display.init(); for older Waveshare HAT's
+#ifndef RENDER_SERVER
+  display.epd2.setBusyCallback(BusyLightSleep, &EPD_BUSY); // Light sleep through each refresh once WiFi is off, see busy_sleep.h
+#endif
   SPI.end();
   SPI.begin(EPD_SCK, EPD_MISO, EPD_MOSI, EPD_CS);
   u8g2Fonts.begin(display); // connect u8g2 procedures to Adafruit GFX
@@ -1134,5 +1237,11 @@ void VerboseRecordOfResetReason(RESET_REASON reason) {
    Version 1.2 / 9.7in
    1. Adjusted graph drawing function to improve negative number drawing Line 1007
    
+   Version 1.3 / 9.7in
+   1. With Renderer set, the display is drawn by a render server and streamed into the IT8951 a band of rows at a time,
+      the render server being this sketch built with RENDER_SERVER on a mains powered ESP32 with PSRAM
+   2. Light sleeps while the panel is busy refreshing, instead of polling BUSY
+   3. Updates on a schedule of per-weekday windows (see schedule.h), sleeping straight to the next update
+   
    
 */
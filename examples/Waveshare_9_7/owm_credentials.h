@@ -16,6 +16,7 @@ String LAT              = "51.38";                         // Home location Lati
 String LON              = "-2.36";                         // Home location Longitude
 
 String City             = "MELKSHAM";                      // Your home city See: http://bulk.openweathermap.org/sample/
+const char* Renderer    = "";                              // e.g. "192.168.1.21", a board with PSRAM running this sketch built with RENDER_SERVER, to only download and show the display
 String Country          = "GB";                            // Your _ISO-3166-1_two-letter_country_code country code, on OWM find your nearest city and the country code is displayed
                                                            // https://en.wikipedia.org/wiki/List_of_ISO_3166_country_codes
 String Language         = "EN";                            // NOTE: Only the weather description is translated by OWM
@@ -0,0 +1,91 @@
+//
+// Failure backoff, so while the access point or the weather server is down a panel stops paying for a WiFi join and
+// a fetch on every wake. Each failure is put in a class, and the network isn't tried again until a delay that
+// doubles with each failure of that class in a row, from its Base up-to its Cap, with the later half of it random
+// so panels that failed together don't all retry together. An HTTP 429 waits at least as long as its Retry-After.
+// A fetch that ran out of wake time isn't counted, as it says nothing of the network. A success clears them all. The time to try again, the run of failures of each class and the totals since power on
+// are kept in RTC memory, so the sketch can also sleep straight through the wakes before it (BackoffUntil).
+// Needs the RTC clock, set on an earlier wake, with no clock every wake tries as before.
+// Include after http_fetch.h and dns_cache.h.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "time.h"
+
+#define BACKOFF_MIN_TIME 1600000000 // A clock before this hasn't been set
+
+enum backoff_class {BACKOFF_NONE = -1, BACKOFF_AUTH, BACKOFF_NO_AP, BACKOFF_DNS, BACKOFF_HTTP_401, BACKOFF_HTTP_429, BACKOFF_HTTP_5XX, BACKOFF_DECODE, BACKOFF_NETWORK, BACKOFF_CLASSES};
+
+typedef struct {
+  const char* Name;
+  uint16_t    Base; // Minutes after the first failure
+  uint16_t    Cap;  // Minutes at most
+} Backoff_rule_type;
+
+const Backoff_rule_type BackoffRules[BACKOFF_CLASSES] = {
+  {"WiFi authentication", 60, 1440}, // A wrong password won't put itself right
+  {"no access point",     15, 480},
+  {"DNS",                 15, 240},
+  {"HTTP 401",            60, 1440}, // The API key was refused
+  {"HTTP 429",            30, 1440}, // Or Retry-After, if it's longer
+  {"HTTP 5xx",            10, 120},
+  {"undecoded response",  10, 240},  // A 200 whose body didn't decode, the API changed or the body was cut short
+  {"network",             10, 120},  // Timeouts, refused connections and the like
+};
+
+RTC_DATA_ATTR uint32_t BackoffUntil = 0; // Unix time before which the network isn't tried, 0 for none
+RTC_DATA_ATTR int8_t   BackoffLast  = -1;
+RTC_DATA_ATTR uint8_t  BackoffStreaks[BACKOFF_CLASSES]; // Failures in a row
+RTC_DATA_ATTR uint16_t BackoffCounts[BACKOFF_CLASSES];  // Since power on
+
+bool BackoffActive();
+void BackoffFailed(int failure, uint32_t retryAfter);
+void BackoffSucceeded();
+int  WiFiFailure(uint8_t status);
+int  FetchFailure(int httpCode);
+
+//#########################################################################################
+// True while backing off, i.e. the network isn't to be tried on this wake
+bool BackoffActive() {
+  time_t now = time(NULL);
+  if (now < BACKOFF_MIN_TIME || now >= BackoffUntil) return false;
+  Serial.println("Backing off after " + String(BackoffRules[BackoffLast].Name) + " failures, the network is next tried in " + String((BackoffUntil - now + 59) / 60) + "-mins");
+  return true;
+}
+//#########################################################################################
+// Records a failure of class failure, and with retryAfter secs from an HTTP 429, 0 if none. BACKOFF_NONE isn't counted.
+void BackoffFailed(int failure, uint32_t retryAfter) {
+  if (failure == BACKOFF_NONE) return;
+  const Backoff_rule_type& rule = BackoffRules[failure];
+  if (BackoffStreaks[failure] < 255) BackoffStreaks[failure]++;
+  BackoffCounts[failure]++;
+  BackoffLast = failure;
+  uint32_t delay = min((uint32_t)rule.Base << min(BackoffStreaks[failure] - 1, 10), (uint32_t)rule.Cap) * 60;
+  delay = delay / 2 + esp_random() % (delay / 2 + 1); // Equal jitter
+  if (retryAfter > delay) delay = retryAfter + esp_random() % (retryAfter / 10 + 1); // Never sooner than asked
+  time_t now = time(NULL);
+  if (now >= BACKOFF_MIN_TIME) BackoffUntil = now + delay;
+  Serial.println(String(rule.Name) + " failure " + String(BackoffStreaks[failure]) + " in a row, " + String(BackoffCounts[failure]) + " since power on, backing off " + String(delay / 60) + "-mins");
+}
+//#########################################################################################
+void BackoffSucceeded() {
+  memset(BackoffStreaks, 0, sizeof(BackoffStreaks));
+  BackoffUntil = 0;
+}
+//#########################################################################################
+// Returns the class of a failed StartWiFi(), from the status it gave up at
+int WiFiFailure(uint8_t status) {
+  if (status == WL_CONNECT_FAILED) return BACKOFF_AUTH;
+  return BACKOFF_NO_AP; // WL_NO_SSID_AVAIL, or still trying when the time was up
+}
+//#########################################################################################
+// Returns the class of a failed fetch, from its HttpCode, or BACKOFF_NONE if it wasn't tried for lack of time
+int FetchFailure(int httpCode) {
+  if (httpCode == FETCH_OVERDUE)         return BACKOFF_NONE;
+  if (httpCode >= 200 && httpCode < 300) return BACKOFF_DECODE;
+  if (httpCode == 401)                   return BACKOFF_HTTP_401;
+  if (httpCode == 429)                   return BACKOFF_HTTP_429;
+  if (httpCode >= 500)                   return BACKOFF_HTTP_5XX;
+  if (httpCode < 0 && DnsFailures > 0)   return BACKOFF_DNS;
+  return BACKOFF_NETWORK;
+}
@@ -0,0 +1,111 @@
+//
+// Battery manager, reads the battery once a wake, before WiFi loads it, and steps the display down as it runs flat:
+//   BATTERY_SAVING     fewer refreshes
+//   BATTERY_NO_GRAPHS  and the forecast graphs aren't drawn
+//   BATTERY_NO_NTP     and the clock isn't set by NTP, the RTC keeps the time across deep sleep
+//   BATTERY_EMPTY      a last low battery frame is shown, which stays on the panel, then it sleeps until touched or reset
+// each below a voltage in the sketch's Battery_type. The reading is a trimmed mean of calibrated ADC samples, and the
+// level steps down with the median of the last three wakes' readings (kept in RTC memory with the rest of the
+// history), so one low reading doesn't step it down, and up again, e.g. once charged, when a reading is
+// BATTERY_HYSTERESIS above the threshold.
+// A board on USB with no battery reads below BATTERY_MIN_VOLTS and is left at BATTERY_NORMAL.
+
+#include <Arduino.h>
+
+#define BATTERY_PIN        35
+#define BATTERY_DIVIDER    2.0  // The board halves the battery voltage for the ADC
+#define BATTERY_SAMPLES    16   // The highest and lowest two are dropped
+#define BATTERY_HISTORY    16   // Wakes
+#define BATTERY_HYSTERESIS 0.05 // Volts
+#define BATTERY_MIN_VOLTS  1.0  // Below this there's no battery
+
+enum battery_level {BATTERY_NORMAL, BATTERY_SAVING, BATTERY_NO_GRAPHS, BATTERY_NO_NTP, BATTERY_EMPTY};
+
+typedef struct {
+  float Saving;      // Volts, below which each level starts
+  float NoGraphs;
+  float NoNTP;
+  float Empty;
+  float Calibration; // Multiplies the reading, a meter's voltage over the one shown
+} Battery_type;
+
+RTC_DATA_ATTR uint16_t BatteryHistory[BATTERY_HISTORY]; // mV, most recent at BatteryCount - 1
+RTC_DATA_ATTR uint32_t BatteryCount = 0;
+RTC_DATA_ATTR uint8_t  BatteryLevel = BATTERY_NORMAL;
+float BatteryVoltage = 0;
+
+const uint8_t BatteryPercentTable[] = {0, 2, 10, 21, 35, 49, 61, 71, 79, 84, 87, 89, 90, 94, 100}; // 3.50v to 4.20v in 50mV steps, for a LiPo cell
+
+int   CheckBattery(const Battery_type& battery);
+float ReadBattery(float calibration);
+int   BatteryLevelFor(float voltage, const Battery_type& battery, float margin);
+int   BatteryPercent(float voltage);
+float BatteryRecent(int wakes);
+
+//#########################################################################################
+// Reads the battery, adds it to the history and returns the level, which is also left in BatteryLevel
+int CheckBattery(const Battery_type& battery) {
+  BatteryVoltage = ReadBattery(battery.Calibration);
+  if (BatteryVoltage < BATTERY_MIN_VOLTS) {
+    BatteryLevel = BATTERY_NORMAL;
+    return BatteryLevel;
+  }
+  BatteryHistory[BatteryCount++ % BATTERY_HISTORY] = BatteryVoltage * 1000;
+  float recent = BatteryRecent(3);
+  int   down   = BatteryLevelFor(recent, battery, 0);
+  int   up     = BatteryLevelFor(BatteryVoltage, battery, BATTERY_HYSTERESIS);
+  if (down > BatteryLevel) BatteryLevel = down;
+  else if (up < BatteryLevel) BatteryLevel = up;
+  const char* names[] = {"normal", "saving", "no graphs", "no NTP", "empty"};
+  Serial.print("Battery " + String(BatteryVoltage, 3) + "v " + String(BatteryPercent(BatteryVoltage)) + "%, level " + names[BatteryLevel]);
+  if (BatteryCount >= BATTERY_HISTORY) Serial.print(", " + String(BatteryHistory[BatteryCount % BATTERY_HISTORY] / 1000.0, 3) + "v " + String(BATTERY_HISTORY) + " wakes ago");
+  Serial.println();
+  return BatteryLevel;
+}
+//#########################################################################################
+// Returns the battery voltage from the mean of the middle BATTERY_SAMPLES - 4 readings, in mV calibrated by the ADC's
+// eFuse values, so one board reads much like another
+float ReadBattery(float calibration) {
+  uint32_t samples[BATTERY_SAMPLES];
+  for (int s = 0; s < BATTERY_SAMPLES; s++) {
+    uint32_t sample = analogReadMilliVolts(BATTERY_PIN);
+    int i = s;
+    for (; i > 0 && samples[i - 1] > sample; i--) samples[i] = samples[i - 1]; // Kept in order
+    samples[i] = sample;
+  }
+  uint32_t sum = 0;
+  for (int s = 2; s < BATTERY_SAMPLES - 2; s++) sum += samples[s];
+  return sum / (BATTERY_SAMPLES - 4) / 1000.0 * BATTERY_DIVIDER * calibration;
+}
+//#########################################################################################
+// Returns the level for voltage, with each threshold raised by margin
+int BatteryLevelFor(float voltage, const Battery_type& battery, float margin) {
+  if (voltage < battery.Empty + margin)    return BATTERY_EMPTY;
+  if (voltage < battery.NoNTP + margin)    return BATTERY_NO_NTP;
+  if (voltage < battery.NoGraphs + margin) return BATTERY_NO_GRAPHS;
+  if (voltage < battery.Saving + margin)   return BATTERY_SAVING;
+  return BATTERY_NORMAL;
+}
+//#########################################################################################
+// Returns the charge left, interpolated from BatteryPercentTable
+int BatteryPercent(float voltage) {
+  const int steps = sizeof(BatteryPercentTable) - 1;
+  float position  = (voltage - 3.50) / 0.05;
+  if (position <= 0)     return 0;
+  if (position >= steps) return 100;
+  int step = position;
+  return BatteryPercentTable[step] + (position - step) * (BatteryPercentTable[step + 1] - BatteryPercentTable[step]) + 0.5;
+}
+//#########################################################################################
+// Returns the median of the last wakes readings, or fewer if there aren't that many yet
+float BatteryRecent(int wakes) {
+  wakes = min((uint32_t)wakes, min(BatteryCount, (uint32_t)BATTERY_HISTORY));
+  uint16_t recent[BATTERY_HISTORY];
+  for (int w = 0; w < wakes; w++) {
+    uint16_t reading = BatteryHistory[(BatteryCount - 1 - w) % BATTERY_HISTORY];
+    int i = w;
+    for (; i > 0 && recent[i - 1] > reading; i--) recent[i] = recent[i - 1];
+    recent[i] = reading;
+  }
+  return wakes > 0 ? recent[wakes / 2] / 1000.0 : 0;
+}
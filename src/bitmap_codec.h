@@ -0,0 +1,226 @@
+//
+// Rendered panel bitmaps, so a mains powered board can draw the display for other panels of the same type and
+// each panel only downloads and shows it. 1 bit per pixel, 1 is white, rows MSB first as Adafruit GFX canvases
+// hold them, each row PackBits compressed on its own so it can be decoded as it arrives:
+//   Header  'W' 'B', version, planes, width (uint16), height (uint16), flags, reserved, all little-endian
+//   Rows    for each row, runs of: n 0..127 then n+1 literal bytes, or n -127..-1 then one byte repeated 1-n times
+// Served by a sketch built with RENDER_SERVER, Waveshare_7_5 or Waveshare_9_7, for panels built from the same sketch.
+// A panel with a frame buffer draws it a row at a time (ReceiveBitmap), one without, e.g. the 9.7" IT8951, has it
+// written into its controller a band of rows at a time (ReceiveBitmapBands).
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+
+#define BITMAP_VERSION     1
+#define BITMAP_HEADER_SIZE 10
+#define BITMAP_PACKBITS    0x01 // Flags
+#define BITMAP_MAX_ROW     256  // bytes, a 2048 pixel wide panel
+#define RENDER_PORT        8081
+#define RENDER_PATH        "/bitmap"
+#define RENDER_TIMEOUT     5000 // ms
+#define BITMAP_BAND_ROWS   16   // Rows in each of the two band buffers, 4.8k for a 1200 pixel wide panel
+#define BITMAP_TASK_STACK  4096
+
+typedef void (*Bitmap_row_type)(int y, const uint8_t* row, int width);
+typedef void (*Bitmap_band_type)(int y, const uint8_t* band, int width, int rows);
+
+typedef struct { // A band ready for the sink, or with Rows 0, the end of the bitmap after Y rows
+  int Band;
+  int Y;
+  int Rows;
+} Bitmap_band_message_type;
+
+typedef struct { // Shared by ReceiveBitmapBands and the task decoding into its bands
+  Stream*       Source;
+  uint8_t*      Bands;
+  size_t        RowBytes;
+  int           Height;
+  QueueHandle_t Free;
+  QueueHandle_t Full;
+} Bitmap_pipe_type;
+
+class PackBitsReader {
+  public:
+    PackBitsReader(Stream& source) : _source(source) {}
+    bool ReadRow(uint8_t* row, size_t bytes) { // False if the source ends or a run crosses the end of the row
+      size_t filled = 0;
+      while (filled < bytes) {
+        int header = _source.read();
+        if (header < 0) return false;
+        int8_t n = (int8_t)header;
+        if (n >= 0) {
+          if (filled + n + 1 > bytes || _source.readBytes(row + filled, n + 1) != (size_t)(n + 1)) return false;
+          filled += n + 1;
+        }
+        else if (n != -128) { // -128 is a no-op
+          int value = _source.read();
+          if (value < 0 || filled + 1 - n > bytes) return false;
+          memset(row + filled, value, 1 - n);
+          filled += 1 - n;
+        }
+      }
+      return true;
+    }
+  private:
+    Stream& _source;
+};
+
+uint8_t* EncodeBitmap(const uint8_t* pixels, int width, int height, size_t& size);
+size_t   PackBitsRow(const uint8_t* row, size_t bytes, uint8_t* out);
+bool     ReceiveBitmap(WiFiClient& client, const char* host, String uri, int width, int height, Bitmap_row_type sink);
+bool     ReceiveBitmapBands(WiFiClient& client, const char* host, String uri, int width, int height, Bitmap_band_type sink);
+void     BitmapBandTask(void* parameter);
+int      ReadBitmapBand(PackBitsReader& rows, uint8_t* band, size_t rowBytes, int count);
+bool     CheckBitmapHeader(Stream& body, int width, int height);
+
+//#########################################################################################
+// Returns the compressed bitmap in a heap buffer the caller frees, or NULL if there's no memory for it
+uint8_t* EncodeBitmap(const uint8_t* pixels, int width, int height, size_t& size) {
+  size_t rowBytes = (width + 7) / 8;
+  uint8_t* bitmap = (uint8_t*)malloc(BITMAP_HEADER_SIZE + height * (rowBytes + rowBytes / 128 + 1)); // PackBits worst case
+  if (bitmap == NULL) return NULL;
+  const uint8_t header[BITMAP_HEADER_SIZE] = {'W', 'B', BITMAP_VERSION, 1, (uint8_t)width, (uint8_t)(width >> 8),
+                                              (uint8_t)height, (uint8_t)(height >> 8), BITMAP_PACKBITS, 0};
+  memcpy(bitmap, header, BITMAP_HEADER_SIZE);
+  size = BITMAP_HEADER_SIZE;
+  for (int y = 0; y < height; y++) size += PackBitsRow(pixels + y * rowBytes, rowBytes, bitmap + size);
+  return bitmap;
+}
+//#########################################################################################
+size_t PackBitsRow(const uint8_t* row, size_t bytes, uint8_t* out) {
+  size_t length = 0, i = 0;
+  while (i < bytes) {
+    size_t run = 1;
+    while (i + run < bytes && run < 128 && row[i + run] == row[i]) run++;
+    if (run > 2) { // Shorter runs are cheaper, or no dearer, inside a literal
+      out[length++] = (uint8_t)(1 - (int)run);
+      out[length++] = row[i];
+      i += run;
+      continue;
+    }
+    size_t literal = 1; // Up to the next three equal bytes, which start a run
+    while (i + literal < bytes && literal < 128 &&
+           !(i + literal + 2 < bytes && row[i + literal] == row[i + literal + 1] && row[i + literal] == row[i + literal + 2])) literal++;
+    out[length++] = literal - 1;
+    memcpy(out + length, row + i, literal);
+    length += literal;
+    i += literal;
+  }
+  return length;
+}
+//#########################################################################################
+// Downloads a rendered bitmap and passes it to sink a row at a time as it arrives, so no frame buffer is needed
+// here. Returns false if the render server can't be reached or the bitmap isn't for a display of this size.
+bool ReceiveBitmap(WiFiClient& client, const char* host, String uri, int width, int height, Bitmap_row_type sink) {
+  int phase = PhaseBegin("Bitmap download");
+  HTTPClient http;
+  http.setConnectTimeout(RENDER_TIMEOUT);
+  http.setTimeout(RENDER_TIMEOUT);
+  http.begin(client, host, RENDER_PORT, uri);
+  int  httpCode = http.GET();
+  bool received = false;
+  if (httpCode == HTTP_CODE_OK) {
+    Stream& body = http.getStream();
+    if (CheckBitmapHeader(body, width, height)) {
+      PackBitsReader rows(body);
+      uint8_t row[BITMAP_MAX_ROW];
+      int y = 0;
+      while (y < height && rows.ReadRow(row, (width + 7) / 8)) sink(y++, row, width);
+      received = y == height;
+      if (!received) Serial.println("Bitmap ended at row " + String(y));
+    }
+  }
+  else Serial.printf("Render server %s gave no bitmap, code: %d\n", host, httpCode);
+  http.end();
+  client.stop();
+  PhaseEnd(phase);
+  return received;
+}
+//#########################################################################################
+// As ReceiveBitmap, for a panel with no frame buffer, the sink is given a band of rows at a time, e.g. to write
+// straight into the display controller. A task decodes the next band from the network while the sink writes the
+// last, so the download and the SPI writes overlap, and only two bands are ever held.
+bool ReceiveBitmapBands(WiFiClient& client, const char* host, String uri, int width, int height, Bitmap_band_type sink) {
+  int phase = PhaseBegin("Bitmap bands");
+  HTTPClient http;
+  http.setConnectTimeout(RENDER_TIMEOUT);
+  http.setTimeout(RENDER_TIMEOUT);
+  http.begin(client, host, RENDER_PORT, uri);
+  int  httpCode = http.GET();
+  bool received = false;
+  if (httpCode == HTTP_CODE_OK) {
+    Stream& body = http.getStream();
+    Bitmap_pipe_type pipe = {&body, NULL, (size_t)(width + 7) / 8, height, NULL, NULL};
+    size_t bandSize = BITMAP_BAND_ROWS * pipe.RowBytes;
+    pipe.Bands = (uint8_t*)malloc(2 * bandSize);
+    pipe.Free  = xQueueCreate(2, sizeof(int));
+    pipe.Full  = xQueueCreate(3, sizeof(Bitmap_band_message_type)); // Both bands and the end
+    if (pipe.Bands && pipe.Free && pipe.Full && CheckBitmapHeader(body, width, height)) {
+      for (int b = 0; b < 2; b++) xQueueSend(pipe.Free, &b, 0);
+      Bitmap_band_message_type message = {0, 0, 0};
+      if (xTaskCreatePinnedToCore(BitmapBandTask, "bands", BITMAP_TASK_STACK, &pipe, 1, NULL, portNUM_PROCESSORS > 1 ? 1 - xPortGetCoreID() : 0) == pdPASS) {
+        while (xQueueReceive(pipe.Full, &message, portMAX_DELAY) == pdTRUE && message.Rows > 0) { // The task always ends with Rows 0
+          sink(message.Y, pipe.Bands + message.Band * bandSize, width, message.Rows);
+          xQueueSend(pipe.Free, &message.Band, portMAX_DELAY);
+        }
+      }
+      else { // Not enough memory for the task, decode and write in turn instead
+        PackBitsReader rows(body);
+        while (message.Y < height && (message.Rows = ReadBitmapBand(rows, pipe.Bands, pipe.RowBytes, min(BITMAP_BAND_ROWS, height - message.Y))) > 0) {
+          sink(message.Y, pipe.Bands, width, message.Rows);
+          message.Y += message.Rows;
+        }
+      }
+      received = message.Y == height;
+      if (!received) Serial.println("Bitmap ended at row " + String(message.Y));
+    }
+    else if (!pipe.Bands || !pipe.Free || !pipe.Full) Serial.println("Not enough memory for the bitmap bands");
+    if (pipe.Full) vQueueDelete(pipe.Full);
+    if (pipe.Free) vQueueDelete(pipe.Free);
+    free(pipe.Bands);
+  }
+  else Serial.printf("Render server %s gave no bitmap, code: %d\n", host, httpCode);
+  http.end();
+  client.stop();
+  PhaseEnd(phase);
+  return received;
+}
+//#########################################################################################
+// Decodes the bitmap into whichever band is free, until it ends, then says how many rows there were
+void BitmapBandTask(void* parameter) {
+  Bitmap_pipe_type* pipe = (Bitmap_pipe_type*)parameter;
+  PackBitsReader rows(*pipe->Source);
+  Bitmap_band_message_type message = {0, 0, 0};
+  int y = 0;
+  while (y < pipe->Height && xQueueReceive(pipe->Free, &message.Band, portMAX_DELAY) == pdTRUE) {
+    int wanted   = min(BITMAP_BAND_ROWS, pipe->Height - y);
+    message.Y    = y;
+    message.Rows = ReadBitmapBand(rows, pipe->Bands + message.Band * BITMAP_BAND_ROWS * pipe->RowBytes, pipe->RowBytes, wanted);
+    if (message.Rows == 0) break;
+    xQueueSend(pipe->Full, &message, portMAX_DELAY);
+    y += message.Rows;
+    if (message.Rows < wanted) break; // The rest is missing or damaged
+  }
+  message.Y    = y;
+  message.Rows = 0;
+  xQueueSend(pipe->Full, &message, portMAX_DELAY);
+  vTaskDelete(NULL);
+}
+//#########################################################################################
+// Returns the number of whole rows read into band, count unless the bitmap ends or is damaged
+int ReadBitmapBand(PackBitsReader& rows, uint8_t* band, size_t rowBytes, int count) {
+  int r = 0;
+  while (r < count && rows.ReadRow(band + r * rowBytes, rowBytes)) r++;
+  return r;
+}
+//#########################################################################################
+// Reads the header, true when the bitmap that follows is for a display of this size
+bool CheckBitmapHeader(Stream& body, int width, int height) {
+  uint8_t header[BITMAP_HEADER_SIZE];
+  body.setTimeout(RENDER_TIMEOUT);
+  if (body.readBytes(header, BITMAP_HEADER_SIZE) == BITMAP_HEADER_SIZE && header[0] == 'W' && header[1] == 'B' && header[2] == BITMAP_VERSION &&
+      header[3] == 1 && (header[4] | header[5] << 8) == width && (header[6] | header[7] << 8) == height && (header[8] & BITMAP_PACKBITS) &&
+      (width + 7) / 8 <= BITMAP_MAX_ROW) return true;
+  Serial.println("Bitmap is not for this display");
+  return false;
+}
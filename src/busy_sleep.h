@@ -0,0 +1,45 @@
+//
+// Light sleep while an e-paper panel refreshes, instead of polling its BUSY line at full clock for the 3-15 seconds
+// a full refresh takes. Installed as the GxEPD2 busy callback, which is called for as long as BUSY is active:
+//   display.epd2.setBusyCallback(BusyLightSleep, &EPD_BUSY);
+// each call sleeps until the line changes, or for BUSY_SLEEP_GUARD at most, so GxEPD2's busy timeout still applies.
+// The time slept is recorded as a wake cycle phase (see wake_metrics.h), and isn't counted as time at either CPU clock
+// (see cpu_clock.h).
+// Include after common.h.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
+#define BUSY_SLEEP_GUARD 1000 // ms, the longest light sleep before BUSY is read again
+
+int64_t BusySleptTime  = 0; // us in light sleep this wake
+int     BusySleepCount = 0;
+int     BusyPhase      = -1;
+
+void BusyLightSleep(const void* parameter);
+
+//#########################################################################################
+// parameter points to the BUSY pin number. Sleeps until the line leaves the level it's at now, the busy level,
+// as GxEPD2 only calls this while the panel is busy, so it works for panels that are busy high or busy low.
+void BusyLightSleep(const void* parameter) {
+  if (WiFi.getMode() != WIFI_OFF) return; // Light sleep would drop the connection, so GxEPD2 polls as before
+  gpio_num_t busy = (gpio_num_t) * (const uint8_t*)parameter;
+  if (BusySleepCount == 0) BusyPhase = PhaseBegin("Panel busy, light sleep");
+  Serial.flush(); // The UART stops while asleep
+  gpio_wakeup_enable(busy, digitalRead(busy) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup(BUSY_SLEEP_GUARD * 1000ULL);
+  int64_t start = esp_timer_get_time();
+  esp_light_sleep_start();
+  int64_t slept = esp_timer_get_time() - start;
+  BusySleptTime += slept;
+  CpuClockSlept(slept / 1000);
+  BusySleepCount++;
+  gpio_wakeup_disable(busy);
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO); // Leaves deep sleep's own wake sources to BeginSleep()
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+  if (BusyPhase >= 0) Phases[BusyPhase].Elapsed = BusySleptTime / 1000;
+}
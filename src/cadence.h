@@ -0,0 +1,62 @@
+//
+// Adaptive refresh cadence, a longer sleep while the weather is settled and a shorter one while it's changing, so a
+// week of high pressure costs fewer refreshes than a frontal passage. Pressure, the chance of precipitation and the
+// temperature are each given the most they may change by between refreshes, and the sleep ends before the hourly
+// forecast (WxForecast[]) says any of them will have changed by more than that:
+//   pressure, the value WxConditions[0].Trend is the slope of, in hPa whatever the Units, as OWM gives it
+//   the chance of precipitation, WxForecast[].PoP
+//   temperature, which also shortens the sleep if it changed by more than allowed since it was last shown, as then
+//   the forecast was behind the weather
+// Include after common.h.
+
+#include <Arduino.h>
+
+typedef struct {
+  int   MinSleep;    // Minutes
+  int   MaxSleep;    // Minutes, the sleep while the weather is settled
+  float Pressure;    // hPa, the most each may change by between refreshes, 0 to ignore it
+  float PoP;         // 0-1
+  float Temperature; // Degrees C
+} Cadence_type;
+
+RTC_DATA_ATTR float CadenceShown = NAN; // Temperature last shown, in the units shown
+
+int   NextCadence(const Cadence_type& cadence);
+float CadenceHorizon(const char* name, float Forecast_record_type::*field, float change);
+void  CadenceDisplayed();
+
+//#########################################################################################
+// Returns the minutes to sleep before the next refresh, between MinSleep and MaxSleep
+int NextCadence(const Cadence_type& cadence) {
+  float minutes = cadence.MaxSleep;
+  if (cadence.Pressure > 0)    minutes = min(minutes, CadenceHorizon("pressure", &Forecast_record_type::Pressure, cadence.Pressure)); // Only the current pressure is converted to inHg
+  if (cadence.PoP > 0)         minutes = min(minutes, CadenceHorizon("precipitation", &Forecast_record_type::PoP, cadence.PoP));
+  if (cadence.Temperature > 0) {
+    float change = Units == "I" ? cadence.Temperature * 9 / 5 : cadence.Temperature; // The limits are metric
+    minutes = min(minutes, CadenceHorizon("temperature", &Forecast_record_type::Temperature, change));
+    float shown = isnan(CadenceShown) ? 0 : fabsf(WxConditions[0].Temperature - CadenceShown);
+    if (shown > change) minutes = minutes * change / shown;
+  }
+  int sleep = constrain((int)minutes, cadence.MinSleep, cadence.MaxSleep);
+  Serial.println("Next refresh in " + String(sleep) + "-mins");
+  return sleep;
+}
+//#########################################################################################
+// Returns the minutes until the hourly forecast of field first differs from the current hour's by more than change
+float CadenceHorizon(const char* name, float Forecast_record_type::*field, float change) {
+  float now = WxForecast[0].*field;
+  for (int r = 1; r < max_readings; r++) {
+    float difference = fabsf(WxForecast[r].*field - now);
+    if (difference <= change) continue;
+    float previous = fabsf(WxForecast[r - 1].*field - now);
+    float minutes  = 60 * (r - 1 + (change - previous) / (difference - previous)); // Interpolated within the hour
+    Serial.println("Cadence set by " + String(name) + " in " + String(minutes, 0) + "-mins");
+    return minutes;
+  }
+  return 60 * (max_readings - 1);
+}
+//#########################################################################################
+// Call when the display has been refreshed with the decoded forecast
+void CadenceDisplayed() {
+  CadenceShown = WxConditions[0].Temperature;
+}
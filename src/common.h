@@ -2,6 +2,14 @@
 
 #include <Arduino.h>
 #include <HTTPClient.h>
+#include "http_stream.h"
+#include "wake_metrics.h"
+#include "cpu_clock.h"
+#include "dns_cache.h"
+
+#ifndef OWM_PORT
+#define OWM_PORT 80 // Define as 443 before including common.h to fetch over HTTPS, and pass a TlsClient (tls_client.h) to ReceiveOneCallWeather()
+#endif
 
 typedef struct { // For current Day and Day 1, 2, 3, etc
   String Time;
@@ -51,8 +59,15 @@ Forecast_record_type  WxConditions[1];
 Forecast_record_type  WxForecast[max_readings];
 Forecast_record_type  Daily[8];
 
+#include "onecall_parser.h"
+
 bool ReceiveOneCallWeather(WiFiClient& client, bool print);
-bool DecodeOneCallWeather(WiFiClient& json, bool print);
+bool DecodeOneCallWeather(Stream& json, bool print);
+bool DecodeOneCallStreamed(Stream& json, bool print);
+void FinishOneCallWeather();
+String DecodedText(const char* text);
+String OneCallUri();
+String OneCallUri(String lat, String lon);
 void Convert_Readings_to_Imperial();
 String ConvertUnixTime(int unix_time);
 float mm_to_inches(float value_mm);
@@ -84,17 +99,40 @@ String ConvertUnixTime(int unix_time) {
 }
 //#########################################################################################
 // Test call: http://api.openweathermap.org/data/3.0/onecall?lat=33&lon=-112&APPID=1a838280c1f7a40c3f8a5e5bc573e22d&mode=json&units=metric&lang=US&exclude=minutely
+String OneCallUri() {
+  return OneCallUri(LAT, LON);
+}
+//#########################################################################################
+String OneCallUri(String lat, String lon) {
+  const String units = (Units == "M" ? "metric" : "imperial");
+  // Update for API 3.0 June '24
+  return "/data/3.0/onecall?lat=" + lat + "&lon=" + lon + "&appid=" + apikey + "&mode=json&units=" + units + "&lang=" + Language + "&exclude=minutely";
+}
+//#########################################################################################
 bool ReceiveOneCallWeather(WiFiClient& client, bool print) {
   Serial.println("Rx weather data...");
-  const String units = (Units == "M" ? "metric" : "imperial");
   client.stop(); // close connection before sending a new request
+  ConnectCached(client, server, OWM_PORT); // If this fails, HTTPClient resolves the server and tries again itself
   HTTPClient http;    
-  // Update for API 3.0 June '24
-  String uri = "/data/3.0/onecall?lat=" + LAT + "&lon=" + LON + "&appid=" + apikey + "&mode=json&units=" + units + "&lang=" + Language + "&exclude=minutely";
-  http.begin(client, server, 80, uri);
+  http.begin(client, server, OWM_PORT, OneCallUri());
+  PrepareBodyRequest(http);
   int httpCode = http.GET();
   if(httpCode == HTTP_CODE_OK) {
-    if (!DecodeOneCallWeather(http.getStream(), print)) return false;
+    HttpBodyStream body(http.getStream(), http.getSize(), ChunkedBody(http));
+    GzipStream     gzip(body);
+    bool gzipped = GzipBody(http);
+    Stream& json = gzipped ? (Stream&)gzip : (Stream&)body;
+#ifdef ONECALL_BUFFERED_DECODE
+#ifdef ONECALL_STREAM_PARSER
+    Body_decoder_type decoders[] = {DecodeOneCallStreamed}; // DecodeOneCallWeather() is this already
+#else
+    Body_decoder_type decoders[] = {DecodeOneCallWeather, DecodeOneCallStreamed}; // Retried without a document if it doesn't fit
+#endif
+    if (!DecodeBufferedBody(json, gzipped ? -1 : http.getSize(), decoders, sizeof(decoders) / sizeof(decoders[0]), print)) return false;
+#else
+    if (!DecodeOneCallWeather(json, print)) return false;
+#endif
+    if (gzipped) Serial.println("Inflated " + String(gzip.CompressedBytes()) + " to " + String(gzip.InflatedBytes()) + " bytes");
     client.stop();
     http.end();
     return true;
@@ -110,13 +148,26 @@ bool ReceiveOneCallWeather(WiFiClient& client, bool print) {
   return true;
 }
 //#######################################################################################
-bool DecodeOneCallWeather(WiFiClient& json, bool print) {
+bool DecodeOneCallWeather(Stream& json, bool print) {
+#ifdef ONECALL_STREAM_PARSER
+  return DecodeOneCallStreamed(json, print);
+#else
   if (print) Serial.println("Decoding Wx Data...");
+  LimitedStream limited(json, ONECALL_MAX_BODY);           // Bounds decode time and document size
+  JsonDocument  filter;                                    // Only the values decoded below are kept, so e.g. alerts take no memory
+  filter["timezone_offset"] = true;
+  filter["current"]         = true;
+  const char* hourlyKeys[]  = {"dt", "temp", "feels_like", "pressure", "humidity", "dew_point", "pop", "rain", "snow"};
+  for (const char* key : hourlyKeys) filter["hourly"][0][key] = true;
+  filter["hourly"][0]["weather"][0]["icon"] = true;
+  const char* dailyKeys[]   = {"dt", "summary", "temp", "humidity", "pop", "uvi", "rain", "snow"};
+  for (const char* key : dailyKeys) filter["daily"][0][key] = true;
+  filter["daily"][0]["weather"][0]["icon"] = true;
   JsonDocument doc;                                        // allocate the JsonDocument
-  DeserializationError error = deserializeJson(doc, json); // Deserialize the JSON document
+  DeserializationError error = deserializeJson(doc, limited, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(ONECALL_MAX_DEPTH));
   if (error) {                                             // Test if parsing succeeds.
     Serial.print("deserializeJson() failed: ");
-    Serial.println(error.c_str());
+    Serial.println(limited.Exhausted() ? "response exceeds " + String(ONECALL_MAX_BODY) + " bytes" : String(error.c_str()));
     return false;
   }
   // convert it to a JsonObject
@@ -124,57 +175,58 @@ bool DecodeOneCallWeather(WiFiClient& json, bool print) {
   const char* TempString;
   Serial.println("\nDecoding data...");
   if (print) Serial.println("Displaying CURRENT conditions..."); // Needed for the main display items
-  WxConditions[0].Timezone    = doc["timezone_offset"];      if (print) Serial.println("TZon: " + String(WxConditions[0].Timezone));
+  WxConditions[0].Timezone    = NumberAs<int>(doc["timezone_offset"].as<double>());      if (print) Serial.println("TZon: " + String(WxConditions[0].Timezone));
   JsonObject current = doc["current"];
   JsonObject current_weather_0 = current["weather"][0];
   int weather_id = current_weather_0["id"]; // 800
   const char* main_weather = current_weather_0["main"]; // "Clear"
   const char* weather = current_weather_0["description"]; // "Clear Skies"
-  WxConditions[0].Description = String(weather);              if (print) Serial.println("Fore: " + String(weather));
+  WxConditions[0].Description = DecodedText(weather);         if (print) Serial.println("Fore: " + String(weather));
   const char* current_icon = current_weather_0["icon"];
-  WxConditions[0].Icon        = current_icon;                 if (print) Serial.println("Icon: " + String(WxConditions[0].Icon));
-  int sunriseL =  int(WxConditions[0].Timezone) + int(current["sunrise"]);
-  WxConditions[0].Sunrise     = current["sunrise"];           if (print) Serial.println("SRis: " + String(WxConditions[0].Sunrise) + " " + ConvertUnixTime(sunriseL));
-  int sunsetL  =  int(WxConditions[0].Timezone) + int(current["sunset"]);
-  WxConditions[0].Sunset      = current["sunset"];            if (print) Serial.println("SSet: " + String(WxConditions[0].Sunset)  + " " + ConvertUnixTime(sunsetL));
+  WxConditions[0].Icon        = DecodedText(current_icon);   if (print) Serial.println("Icon: " + String(WxConditions[0].Icon));
+  WxConditions[0].Sunrise     = NumberAs<int>(current["sunrise"].as<double>()); if (print) Serial.println("SRis: " + String(WxConditions[0].Sunrise) + " " + ConvertUnixTime(WxConditions[0].Sunrise + (int64_t)WxConditions[0].Timezone));
+  WxConditions[0].Sunset      = NumberAs<int>(current["sunset"].as<double>());  if (print) Serial.println("SSet: " + String(WxConditions[0].Sunset)  + " " + ConvertUnixTime(WxConditions[0].Sunset + (int64_t)WxConditions[0].Timezone));
   WxConditions[0].Temperature = current["temp"];              if (print) Serial.println("Temp: " + String(WxConditions[0].Temperature));
   WxConditions[0].FeelsLike   = current["feels_like"];        if (print) Serial.println("FLik: " + String(WxConditions[0].FeelsLike));
   WxConditions[0].Pressure    = current["pressure"];          if (print) Serial.println("Pres: " + String(WxConditions[0].Pressure));
   WxConditions[0].Humidity    = current["humidity"];          if (print) Serial.println("Humi: " + String(WxConditions[0].Humidity));
   WxConditions[0].DewPoint    = current["dew_point"];         if (print) Serial.println("DewP: " + String(WxConditions[0].DewPoint));
   WxConditions[0].UVI         = current["uvi"];               if (print) Serial.println("UVin: " + String(WxConditions[0].UVI));
-  WxConditions[0].Cloudcover  = current["clouds"];            if (print) Serial.println("CCov: " + String(WxConditions[0].Cloudcover));
-  WxConditions[0].Visibility  = current["visibility"];        if (print) Serial.println("Visi: " + String(WxConditions[0].Visibility));
+  WxConditions[0].Cloudcover  = NumberAs<int>(current["clouds"].as<double>());          if (print) Serial.println("CCov: " + String(WxConditions[0].Cloudcover));
+  WxConditions[0].Visibility  = NumberAs<int>(current["visibility"].as<double>());      if (print) Serial.println("Visi: " + String(WxConditions[0].Visibility));
   WxConditions[0].Windspeed   = current["wind_speed"];        if (print) Serial.println("WSpd: " + String(WxConditions[0].Windspeed));
   WxConditions[0].Winddir     = current["wind_deg"];          if (print) Serial.println("WDir: " + String(WxConditions[0].Winddir));
 
   JsonArray hourlyArray = doc["hourly"];
+  if (hourlyArray.size() < max_readings) Serial.println("Only " + String(hourlyArray.size()) + " hourly forecasts, the rest read as 0");
 
   if (print) Serial.println("\nDisplaying 48-hrs of HOURLY data..."); // Needed for the graphs
   for (int r = 0; r < max_readings; r++) {
     JsonObject hourly = hourlyArray[r];
     if (print) Serial.println("Day (Hour)-" + String(r) + " --------------");
-    WxForecast[r].Dt          = hourly["dt"];                 if (print) Serial.println(ConvertUnixTime(WxForecast[r].Dt));
+    WxForecast[r].Dt          = NumberAs<int>(hourly["dt"].as<double>());              if (print) Serial.println(ConvertUnixTime(WxForecast[r].Dt));
     WxForecast[r].Temperature = hourly["temp"];               if (print) Serial.println("Temp: " + String(WxForecast[r].Temperature));
     WxForecast[r].FeelsLike   = hourly["feels_like"];         if (print) Serial.println("FLik: " + String(WxForecast[r].FeelsLike));
     WxForecast[r].Pressure    = hourly["pressure"];           if (print) Serial.println("Pres: " + String(WxForecast[r].Pressure));
     WxForecast[r].Humidity    = hourly["humidity"];           if (print) Serial.println("Humi: " + String(WxForecast[r].Humidity));
     WxForecast[r].DewPoint    = hourly["dew_point"];          if (print) Serial.println("DewP: " + String(WxForecast[r].DewPoint));
+    WxForecast[r].PoP         = hourly["pop"];                if (print) Serial.println("PoP : " + String(WxForecast[r].PoP * 100, 0) + "%");
     WxForecast[r].Rainfall    = hourly["rain"]["1h"];         if (print) Serial.println("Rain: " + String(WxForecast[r].Rainfall));
     WxForecast[r].Snowfall    = hourly["snow"]["1h"];         if (print) Serial.println("Snow: " + String(WxForecast[r].Snowfall));
     WxForecast[r].Rainfall    = hourly["rain"]["1h"];         if (print) Serial.println("Rain: " + String(WxForecast[r].Rainfall));
     WxForecast[r].Snowfall    = hourly["snow"]["1h"];         if (print) Serial.println("Snow: " + String(WxForecast[r].Snowfall));
     JsonObject hourly_weather = hourly["weather"][0];
-    WxForecast[r].Icon        = hourly["weather"][0]["icon"].as<const char*>(); if (print) Serial.println("Icon: " + String(WxForecast[r].Icon));
+    WxForecast[r].Icon        = DecodedText(hourly["weather"][0]["icon"]); if (print) Serial.println("Icon: " + String(WxForecast[r].Icon));
   }
 
   JsonArray daily = doc["daily"];
+  if (daily.size() < 8) Serial.println("Only " + String(daily.size()) + " daily forecasts, the rest read as 0");
   if (print) Serial.println("\nDisplaying DAILY Data --------------"); // Neded for the 7-day forecast section
   for (int r = 0; r < 8; r++) { // Maximum of 8-days!
     if (print) Serial.println("\nData for DAY - " + String(r) + " --------------");
     JsonObject daily_values = daily[r];
-    Daily[r].Dt          = daily_values["dt"];                                   if (print) Serial.println(ConvertUnixTime(Daily[r].Dt));
-    Daily[r].Description = daily_values["summary"].as<const char*>();            if (print) Serial.println("Summary: " + Daily[r].Description);
+    Daily[r].Dt          = NumberAs<int>(daily_values["dt"].as<double>());                              if (print) Serial.println(ConvertUnixTime(Daily[r].Dt));
+    Daily[r].Description = DecodedText(daily_values["summary"]);                 if (print) Serial.println("Summary: " + Daily[r].Description);
     Daily[r].Temperature = daily_values["temp"]["day"];                          if (print) Serial.println("Temp   : " + String(Daily[r].Temperature));
     Daily[r].High        = daily_values["temp"]["max"];                          if (print) Serial.println("High   : " + String(Daily[r].High));
     Daily[r].Low         = daily_values["temp"]["min"];                          if (print) Serial.println("Low    : " + String(Daily[r].Low));
@@ -183,17 +235,43 @@ bool DecodeOneCallWeather(WiFiClient& json, bool print) {
     Daily[r].UVI         = daily_values["uvi"];                                  if (print) Serial.println("UVI    : " + String(Daily[r].UVI, 1));
     Daily[r].Rainfall    = daily_values["rain"];                                 if (print) Serial.println("Rain   : " + String(Daily[r].Rainfall));
     Daily[r].Snowfall    = daily_values["snow"];                                 if (print) Serial.println("Snow   : " + String(Daily[r].Snowfall));
-    Daily[r].Icon        = daily_values["weather"][0]["icon"].as<const char*>(); if (print) Serial.println("Icon   : " + String(Daily[r].Icon));
+    Daily[r].Icon        = DecodedText(daily_values["weather"][0]["icon"]);     if (print) Serial.println("Icon   : " + String(Daily[r].Icon));
+  }
+  FinishOneCallWeather();
+  return true;
+#endif
+}
+//#######################################################################################
+// Decodes with the streaming parser, which needs no document, so it's also the retry when a document doesn't fit
+bool DecodeOneCallStreamed(Stream& json, bool print) {
+  if (print) Serial.println("Decoding Wx Data...");
+  LimitedStream limited(json, ONECALL_MAX_BODY);
+  OneCallParser parser(limited);
+  if (!parser.Parse()) {
+    Serial.print("One Call parse failed: ");
+    Serial.println(limited.Exhausted() ? "response exceeds " + String(ONECALL_MAX_BODY) + " bytes" : String(parser.Error()));
+    return false;
   }
+  if (print) Serial.println("Decoded " + String(parser.Fields()) + " fields");
+  FinishOneCallWeather();
+  return true;
+}
+//#######################################################################################
+String DecodedText(const char* text) { // Capped as the streaming parser caps it, so a hostile response can't exhaust the heap
+  String decoded = text;
+  if (decoded.length() >= ONECALL_TOKEN_SIZE) decoded.remove(ONECALL_TOKEN_SIZE - 1);
+  return decoded;
+}
+//#######################################################################################
+void FinishOneCallWeather() { // Values derived from the decoded records, whichever decoder was used
   //------------------------------------------
   float pressure_trend = WxForecast[0].Pressure - WxForecast[2].Pressure; // Measure pressure slope between ~now and later
-  pressure_trend = ((int)(pressure_trend * 10)) / 10.0; // Remove any small variations of less than 0.1
+  pressure_trend = truncf(pressure_trend * 10) / 10.0; // Remove any small variations of less than 0.1
   WxConditions[0].Trend = "=";
   if (pressure_trend > 0)  WxConditions[0].Trend = "+";
   if (pressure_trend < 0)  WxConditions[0].Trend = "-";
   if (pressure_trend == 0) WxConditions[0].Trend = "0";
   if (Units == "I") Convert_Readings_to_Imperial();
-  return true;
 }
 
 float mm_to_inches(float value_mm){
@@ -0,0 +1,125 @@
+//
+// CPU clock governor, so the seconds a wake spends waiting on WiFi, the clock and HTTP aren't spent at 240MHz. The
+// clock is held at the profile's IoMHz, 80MHz being the lowest at which WiFi still works, and raised to its WorkMHz
+// only between CpuWorkBegin() and CpuWorkEnd(), e.g. around a TLS handshake, a JSON decode or drawing the display.
+// Work may be begun from the fetch tasks as well as from setup(), the clock stays raised while any is under way.
+// With power management in the build (CONFIG_PM_ENABLE) it's done with an ESP-IDF power management lock, otherwise
+// with setCpuFrequencyMhz(). The time at each clock is kept, and PrintCpuClock() estimates the CPU's energy from the
+// board profile's currents, against the same wake at WorkMHz throughout. The radio's is the same at either clock.
+// Until CpuClockBegin() is called the clock isn't changed, so a sketch without it runs at the default as before.
+
+#include <Arduino.h>
+#ifdef CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+#define CPU_VOLTS 3.3
+
+enum cpu_level {CPU_IO, CPU_WORK};
+
+typedef struct {
+  const char* Name;
+  uint16_t    IoMHz;
+  uint16_t    WorkMHz;
+  float       IoMilliAmps;   // Both cores running, the radio off, from the datasheet
+  float       WorkMilliAmps;
+} Cpu_profile_type;
+
+const Cpu_profile_type CpuESP32   = {"ESP32",    80, 240, 31, 68};
+const Cpu_profile_type CpuESP32S3 = {"ESP32-S3", 80, 240, 28, 56};
+
+const Cpu_profile_type* CpuProfile = NULL;
+SemaphoreHandle_t       CpuLock    = NULL;
+int                     CpuWork    = 0; // Work under way
+int                     CpuLevel   = CPU_WORK;
+unsigned long           CpuSince   = 0; // ms since boot the clock was last changed
+unsigned long           CpuTime[2];     // ms at each level
+#ifdef CONFIG_PM_ENABLE
+esp_pm_lock_handle_t    CpuPmLock  = NULL; // Held while working, NULL if the clock is set by setCpuFrequencyMhz()
+#endif
+
+void CpuClockBegin(const Cpu_profile_type& profile);
+void CpuWorkBegin();
+void CpuWorkEnd();
+void CpuClockSet(int level);
+void CpuClockSlept(unsigned long ms);
+void PrintCpuClock();
+
+//#########################################################################################
+// Call once, early in setup(), before the time spent waiting
+void CpuClockBegin(const Cpu_profile_type& profile) {
+  CpuLock = xSemaphoreCreateMutex();
+  if (CpuLock == NULL) return;
+  CpuSince = millis();
+  CpuTime[CPU_IO] = CpuTime[CPU_WORK] = 0;
+#ifdef CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t config = {};
+#elif CONFIG_IDF_TARGET_ESP32S3
+  esp_pm_config_esp32s3_t config = {};
+#else
+  esp_pm_config_esp32_t config = {};
+#endif
+  config.max_freq_mhz       = profile.WorkMHz;
+  config.min_freq_mhz       = profile.IoMHz;
+  config.light_sleep_enable = false; // The panel refresh sleeps for itself, see busy_sleep.h
+  if (esp_pm_configure(&config) != ESP_OK || esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "work", &CpuPmLock) != ESP_OK) CpuPmLock = NULL;
+  if (CpuPmLock) esp_pm_lock_acquire(CpuPmLock); // Held at CPU_WORK, the level it starts at
+#endif
+  CpuProfile = &profile;
+  CpuClockSet(CPU_IO);
+}
+//#########################################################################################
+void CpuWorkBegin() {
+  if (CpuProfile == NULL) return;
+  xSemaphoreTake(CpuLock, portMAX_DELAY);
+  if (CpuWork++ == 0) CpuClockSet(CPU_WORK);
+  xSemaphoreGive(CpuLock);
+}
+//#########################################################################################
+void CpuWorkEnd() {
+  if (CpuProfile == NULL) return;
+  xSemaphoreTake(CpuLock, portMAX_DELAY);
+  if (CpuWork > 0 && --CpuWork == 0) CpuClockSet(CPU_IO);
+  xSemaphoreGive(CpuLock);
+}
+//#########################################################################################
+// Changes the clock to level, and counts the time at the last
+void CpuClockSet(int level) {
+  if (level == CpuLevel) return;
+  unsigned long now = millis();
+  CpuTime[CpuLevel] += now - CpuSince;
+  CpuSince = now;
+  CpuLevel = level;
+#ifdef CONFIG_PM_ENABLE
+  if (CpuPmLock) {
+    if (level == CPU_WORK) esp_pm_lock_acquire(CpuPmLock);
+    else                   esp_pm_lock_release(CpuPmLock);
+    return;
+  }
+#endif
+  setCpuFrequencyMhz(level == CPU_WORK ? CpuProfile->WorkMHz : CpuProfile->IoMHz);
+}
+//#########################################################################################
+// Takes ms spent in light sleep off the time at the current level, as the CPU wasn't running
+void CpuClockSlept(unsigned long ms) {
+  if (CpuProfile == NULL) return;
+  CpuSince = min(CpuSince + ms, millis());
+}
+//#########################################################################################
+void PrintCpuClock() {
+  if (CpuProfile == NULL) return;
+  CpuTime[CpuLevel] += millis() - CpuSince;
+  CpuSince = millis();
+  const Cpu_profile_type& p = *CpuProfile;
+  const char* how = "";
+#ifdef CONFIG_PM_ENABLE
+  if (CpuPmLock) how = ", power management lock";
+#endif
+  float io       = CpuTime[CPU_IO] * p.IoMilliAmps * CPU_VOLTS / 1000;     // mJ
+  float work     = CpuTime[CPU_WORK] * p.WorkMilliAmps * CPU_VOLTS / 1000;
+  float constant = (CpuTime[CPU_IO] + CpuTime[CPU_WORK]) * p.WorkMilliAmps * CPU_VOLTS / 1000;
+  Serial.printf("CPU clock (%s%s): %uMHz %lu-ms ~%.0fmJ, %uMHz %lu-ms ~%.0fmJ, ~%.0fmJ in all, ~%.0fmJ at %uMHz throughout\n",
+                p.Name, how, p.IoMHz, CpuTime[CPU_IO], io, p.WorkMHz, CpuTime[CPU_WORK], work,
+                io + work, constant, p.WorkMHz);
+}
@@ -0,0 +1,179 @@
+//
+// Resolver cache, keeps the address of each server and the TTL it was given in RTC memory, so a wake only
+// queries DNS when an address has expired or no longer accepts connections. The query is made directly to
+// the DNS server given by DHCP, as the system resolver doesn't report TTLs.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include "time.h"
+
+#define DNS_CACHE_SIZE   4     // Hosts kept across deep-sleep
+#define DNS_TIMEOUT      1000  // ms to wait for an answer before falling back to the system resolver
+#define DNS_FALLBACK_TTL 300   // secs to keep an address when the TTL is unknown
+#define DNS_MAX_TTL      86400 // secs, caps the TTL in case the clock is stepped by NTP
+#define DNS_PACKET_SIZE  512
+
+typedef struct {
+  uint32_t HostHash;
+  uint32_t Address;
+  uint32_t Expires; // Unix time, the RTC keeps time during deep-sleep
+} Dns_entry_type;
+
+RTC_DATA_ATTR Dns_entry_type DnsCache[DNS_CACHE_SIZE];
+int DnsFailures = 0; // Hosts that couldn't be resolved this wake
+
+bool     ResolveHost(const char* host, IPAddress& ip);
+void     ForgetHost(const char* host);
+bool     ConnectCached(WiFiClient& client, const char* host, uint16_t port);
+bool     QueryDns(const char* host, IPAddress& ip, uint32_t& ttl);
+bool     ReadDnsAnswer(const uint8_t* answer, int length, const uint8_t* query, int queryLength, IPAddress& ip, uint32_t& ttl);
+int      SkipDnsName(const uint8_t* packet, int length, int offset);
+uint32_t HostHash(const char* host);
+
+//#########################################################################################
+bool ResolveHost(const char* host, IPAddress& ip) {
+  uint32_t hash = HostHash(host);
+  uint32_t now  = time(NULL);
+  Dns_entry_type* entry = &DnsCache[0];
+  for (int e = 0; e < DNS_CACHE_SIZE; e++) {
+    if (DnsCache[e].HostHash == hash && DnsCache[e].Address != 0) {
+      if (now < DnsCache[e].Expires) {
+        ip = IPAddress(DnsCache[e].Address);
+        return true;
+      }
+      entry = &DnsCache[e];
+      break;
+    }
+    if (DnsCache[e].Expires < entry->Expires) entry = &DnsCache[e]; // Otherwise replace the entry that expires first
+  }
+  int phase = PhaseBegin("DNS lookup");
+  uint32_t ttl;
+  if (!QueryDns(host, ip, ttl)) {
+    if (!WiFi.hostByName(host, ip)) {
+      Serial.println("DNS: failed to resolve " + String(host));
+      PhaseEnd(phase);
+      DnsFailures++;
+      return false;
+    }
+    ttl = DNS_FALLBACK_TTL;
+  }
+  PhaseEnd(phase);
+  entry->HostHash = hash;
+  entry->Address  = (uint32_t)ip;
+  entry->Expires  = now + min(ttl, (uint32_t)DNS_MAX_TTL);
+  Serial.println("DNS: " + String(host) + " is " + ip.toString() + " for " + String(ttl) + "-secs");
+  return true;
+}
+//#########################################################################################
+void ForgetHost(const char* host) {
+  uint32_t hash = HostHash(host);
+  for (int e = 0; e < DNS_CACHE_SIZE; e++) {
+    if (DnsCache[e].HostHash == hash) {
+      DnsCache[e].Address = 0;
+      DnsCache[e].Expires = 0;
+    }
+  }
+}
+//#########################################################################################
+// Connects by the cached address, so HTTPClient then reuses the connection instead of resolving the host itself.
+// A failed connection may be due to a stale address, so the host is resolved again and the connection retried once.
+bool ConnectCached(WiFiClient& client, const char* host, uint16_t port) {
+  if (client.connected()) return true;
+  IPAddress ip;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (!ResolveHost(host, ip)) return false;
+    if (client.connect(ip, port)) return true;
+    ForgetHost(host);
+  }
+  return false;
+}
+//#########################################################################################
+// Sends one recursive A query and returns the first address in the answer with the lowest TTL of the records
+// that led to it, e.g. a CNAME chain.
+bool QueryDns(const char* host, IPAddress& ip, uint32_t& ttl) {
+  uint8_t  packet[DNS_PACKET_SIZE];
+  uint8_t  answer[DNS_PACKET_SIZE];
+  uint16_t id = esp_random();
+  int length = 0;
+  const uint8_t header[] = {(uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0}; // Recursion desired, one question
+  memcpy(packet, header, sizeof(header));
+  length = sizeof(header);
+  const char* label = host;
+  while (*label) { // Host name as length-prefixed labels
+    const char* dot = strchr(label, '.');
+    int size = dot ? dot - label : strlen(label);
+    if (size == 0 || size > 63 || length + size + 6 > DNS_PACKET_SIZE) return false;
+    packet[length++] = size;
+    memcpy(packet + length, label, size);
+    length += size;
+    label += size + (dot ? 1 : 0);
+  }
+  const uint8_t question[] = {0, 0, 1, 0, 1}; // End of name, type A, class IN
+  memcpy(packet + length, question, sizeof(question));
+  length += sizeof(question);
+  WiFiUDP udp;
+  if (!udp.beginPacket(WiFi.dnsIP(), 53)) return false;
+  udp.write(packet, length);
+  if (!udp.endPacket()) return false;
+  unsigned long start = millis();
+  int received;
+  while ((received = udp.parsePacket()) == 0) {
+    if (millis() - start > DNS_TIMEOUT) {
+      udp.stop();
+      return false;
+    }
+    delay(5);
+  }
+  received = udp.read(answer, sizeof(answer));
+  udp.stop();
+  return ReadDnsAnswer(answer, received, packet, length, ip, ttl);
+}
+//#########################################################################################
+// Reads the address and TTL from the answer to a query, which must be a response (QR set) without error to
+// that query, with its ID and the same question, so a stray or spoofed packet isn't cached for its TTL.
+bool ReadDnsAnswer(const uint8_t* packet, int length, const uint8_t* query, int queryLength, IPAddress& ip, uint32_t& ttl) {
+  if (length < queryLength || packet[0] != query[0] || packet[1] != query[1] || !(packet[2] & 0x80) || (packet[3] & 0x0F) != 0) return false;
+  if ((packet[4] << 8 | packet[5]) != 1) return false;
+  for (int b = 12; b < queryLength; b++) { // The question echoed, letters in either case as some resolvers change it
+    if (tolower(packet[b]) != tolower(query[b])) return false;
+  }
+  int answers = packet[6] << 8 | packet[7];
+  int offset  = queryLength;
+  bool found  = false;
+  ttl = DNS_MAX_TTL;
+  for (int a = 0; a < answers; a++) {
+    offset = SkipDnsName(packet, length, offset);
+    if (offset < 0 || offset + 10 > length) break;
+    uint16_t type      = packet[offset] << 8 | packet[offset + 1];
+    uint32_t recordTtl = (uint32_t)packet[offset + 4] << 24 | (uint32_t)packet[offset + 5] << 16 | packet[offset + 6] << 8 | packet[offset + 7];
+    uint16_t size      = packet[offset + 8] << 8 | packet[offset + 9];
+    offset += 10;
+    if (offset + size > length) break;
+    ttl = min(ttl, recordTtl);
+    if (type == 1 && size == 4) {
+      ip = IPAddress(packet[offset], packet[offset + 1], packet[offset + 2], packet[offset + 3]);
+      found = true;
+      break;
+    }
+    offset += size;
+  }
+  return found;
+}
+//#########################################################################################
+// Returns the offset after a possibly compressed name, or -1 if it runs past the packet
+int SkipDnsName(const uint8_t* packet, int length, int offset) {
+  while (offset >= 0 && offset < length) {
+    uint8_t size = packet[offset];
+    if (size == 0) return offset + 1;
+    if ((size & 0xC0) == 0xC0) return offset + 2 <= length ? offset + 2 : -1; // Pointer to an earlier name ends it
+    offset += size + 1;
+  }
+  return -1;
+}
+//#########################################################################################
+uint32_t HostHash(const char* host) { // FNV-1a, keeps host names out of RTC memory
+  uint32_t hash = 2166136261UL;
+  while (*host) hash = (hash ^ (uint8_t)tolower(*host++)) * 16777619UL;
+  return hash;
+}
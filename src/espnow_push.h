@@ -0,0 +1,218 @@
+//
+// ESP-NOW push, a gateway broadcasts each location's forecast in the wire format (see wire_format.h) and a panel
+// listens for its own location on a fixed channel, so it never associates with the access point, takes a DHCP
+// lease or opens a connection, and is awake for tens of ms instead of seconds.
+// A forecast is split into frames that fit an ESP-NOW packet:
+//   'W' 'N', version, frame index, frame count, sequence (uint32), place (uint32), message length (uint16),
+//   data length, data, then the first PUSH_TAG_SIZE bytes of an HMAC-SHA256 of all that with the shared key
+// The sequence is the gateway's Unix time when it sends, so a panel accepts only a newer message than it last
+// did, can't be made to show an old forecast again, and takes its clock from it. The framing and replay checks
+// don't touch the radio, so they can be exercised off the device by passing frames between them directly.
+// Include after wire_format.h.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include "mbedtls/md.h"
+#include <sys/time.h>
+
+#define PUSH_VERSION      1
+#define PUSH_FRAME_SIZE   250  // ESP-NOW v1 maximum
+#define PUSH_HEADER_SIZE  17
+#define PUSH_TAG_SIZE     8
+#define PUSH_DATA_SIZE    (PUSH_FRAME_SIZE - PUSH_HEADER_SIZE - PUSH_TAG_SIZE)
+#define PUSH_MAX_FRAMES   8
+#define PUSH_MAX_MESSAGE  (PUSH_MAX_FRAMES * PUSH_DATA_SIZE)
+#define PUSH_LISTEN_TIME  1500 // ms a panel listens before giving up and fetching over WiFi
+#define PUSH_MIN_TIME     1600000000UL // A sequence before this isn't a time, so doesn't set the clock
+#define PUSH_MAX_SKEW     120  // secs, once the clock is set an older message is refused, so a recording can't be replayed
+
+enum Push_result_type {PUSH_PENDING, PUSH_COMPLETE, PUSH_BAD_FRAME, PUSH_BAD_TAG, PUSH_OTHER_PLACE, PUSH_REPLAYED};
+
+class PushAssembler {
+  public:
+    PushAssembler(const uint8_t* key, size_t keyLength, uint32_t place, uint32_t lastSequence);
+    Push_result_type Add(const uint8_t* frame, size_t length);
+    const uint8_t*   Message()  { return _message; }
+    size_t           Length()   { return _length; }
+    uint32_t         Sequence() { return _sequence; }
+  private:
+    const uint8_t* _key;
+    size_t         _keyLength;
+    uint32_t       _place;
+    uint32_t       _lastSequence;
+    uint32_t       _sequence;
+    uint32_t       _received;  // Bit for each frame of _sequence
+    size_t         _length;
+    uint8_t        _message[PUSH_MAX_MESSAGE];
+};
+
+RTC_DATA_ATTR uint32_t PushLastSequence = 0;
+
+int      PushFrameCount(size_t length);
+size_t   PushFrame(uint8_t* frame, const uint8_t* message, size_t length, int index, uint32_t sequence, uint32_t place, const uint8_t* key, size_t keyLength);
+void     PushTag(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length, uint8_t* tag);
+uint32_t PushReadU32(const uint8_t* data);
+void     PushWriteU32(uint8_t* data, uint32_t value);
+bool     ReceivePush(const char* key, int channel, uint32_t place, unsigned long listen);
+bool     SendPush(const char* key, const uint8_t* message, size_t length, uint32_t place);
+
+//#########################################################################################
+PushAssembler::PushAssembler(const uint8_t* key, size_t keyLength, uint32_t place, uint32_t lastSequence) :
+  _key(key), _keyLength(keyLength), _place(place), _lastSequence(lastSequence), _sequence(0), _received(0), _length(0) {}
+//#########################################################################################
+// Adds a received frame, and returns PUSH_COMPLETE when every frame of a new message has arrived
+Push_result_type PushAssembler::Add(const uint8_t* frame, size_t length) {
+  if (length < PUSH_HEADER_SIZE + PUSH_TAG_SIZE || frame[0] != 'W' || frame[1] != 'N' || frame[2] != PUSH_VERSION) return PUSH_BAD_FRAME;
+  int      index    = frame[3];
+  int      count    = frame[4];
+  uint32_t sequence = PushReadU32(frame + 5);
+  uint32_t place    = PushReadU32(frame + 9);
+  size_t   total    = frame[13] | frame[14] << 8;
+  size_t   size     = frame[15];
+  if (count == 0 || count > PUSH_MAX_FRAMES || index >= count || count != PushFrameCount(total) || size > PUSH_DATA_SIZE ||
+      length != PUSH_HEADER_SIZE + size + PUSH_TAG_SIZE || index * PUSH_DATA_SIZE + size > total) return PUSH_BAD_FRAME;
+  uint8_t tag[PUSH_TAG_SIZE];
+  PushTag(_key, _keyLength, frame, PUSH_HEADER_SIZE + size, tag);
+  uint8_t difference = 0;
+  for (int t = 0; t < PUSH_TAG_SIZE; t++) difference |= tag[t] ^ frame[PUSH_HEADER_SIZE + size + t]; // Takes the same time whatever differs
+  if (difference != 0) return PUSH_BAD_TAG;
+  if (place != _place) return PUSH_OTHER_PLACE;
+  if (sequence <= _lastSequence || sequence < _sequence) return PUSH_REPLAYED;
+  if (sequence > _sequence) { // A newer message, so anything held of an older one is dropped
+    _sequence = sequence;
+    _received = 0;
+    _length   = total;
+  }
+  else if (total != _length) return PUSH_BAD_FRAME;
+  memcpy(_message + index * PUSH_DATA_SIZE, frame + PUSH_HEADER_SIZE, size);
+  _received |= 1UL << index;
+  if (_received != (1UL << count) - 1) return PUSH_PENDING;
+  _lastSequence = sequence; // So the same message isn't completed again
+  return PUSH_COMPLETE;
+}
+//#########################################################################################
+int PushFrameCount(size_t length) {
+  return max((int)((length + PUSH_DATA_SIZE - 1) / PUSH_DATA_SIZE), 1);
+}
+//#########################################################################################
+// Builds frame index of a message into frame, which needs PUSH_FRAME_SIZE bytes, and returns its length
+size_t PushFrame(uint8_t* frame, const uint8_t* message, size_t length, int index, uint32_t sequence, uint32_t place, const uint8_t* key, size_t keyLength) {
+  size_t offset = index * PUSH_DATA_SIZE;
+  size_t size   = offset < length ? min(length - offset, (size_t)PUSH_DATA_SIZE) : 0;
+  frame[0]  = 'W';
+  frame[1]  = 'N';
+  frame[2]  = PUSH_VERSION;
+  frame[3]  = index;
+  frame[4]  = PushFrameCount(length);
+  PushWriteU32(frame + 5, sequence);
+  PushWriteU32(frame + 9, place);
+  frame[13] = length;
+  frame[14] = length >> 8;
+  frame[15] = size;
+  frame[16] = 0; // Reserved
+  memcpy(frame + PUSH_HEADER_SIZE, message + offset, size);
+  PushTag(key, keyLength, frame, PUSH_HEADER_SIZE + size, frame + PUSH_HEADER_SIZE + size);
+  return PUSH_HEADER_SIZE + size + PUSH_TAG_SIZE;
+}
+//#########################################################################################
+void PushTag(const uint8_t* key, size_t keyLength, const uint8_t* data, size_t length, uint8_t* tag) {
+  uint8_t hmac[32];
+  mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key, keyLength, data, length, hmac);
+  memcpy(tag, hmac, PUSH_TAG_SIZE);
+}
+//#########################################################################################
+uint32_t PushReadU32(const uint8_t* data) {
+  return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+//#########################################################################################
+void PushWriteU32(uint8_t* data, uint32_t value) {
+  for (int b = 0; b < 4; b++) data[b] = value >> (8 * b);
+}
+//#########################################################################################
+// Radio side, frames are copied from the WiFi task into a queue and assembled by the caller
+typedef struct {
+  uint8_t Length;
+  uint8_t Data[PUSH_FRAME_SIZE];
+} Push_frame_type;
+
+QueueHandle_t PushQueue = NULL;
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+void PushReceived(const esp_now_recv_info_t*, const uint8_t* data, int length) { // Any sender, the tag authenticates it
+#else
+void PushReceived(const uint8_t*, const uint8_t* data, int length) {
+#endif
+  if (PushQueue == NULL || length <= 0 || length > PUSH_FRAME_SIZE) return;
+  Push_frame_type frame;
+  frame.Length = length;
+  memcpy(frame.Data, data, length);
+  xQueueSend(PushQueue, &frame, 0); // Dropped if full, the gateway repeats it
+}
+//#########################################################################################
+// Listens for the forecast of place, and when a complete, authentic and new one arrives, decodes it into the
+// records and sets the clock from it. Returns false after listen ms without one, so the caller can use WiFi.
+bool ReceivePush(const char* key, int channel, uint32_t place, unsigned long listen) {
+  int phase = PhaseBegin("ESP-NOW receive");
+  WiFi.mode(WIFI_STA);
+  esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+  PushQueue = xQueueCreate(PUSH_MAX_FRAMES * 2, sizeof(Push_frame_type));
+  bool decoded = false;
+  if (PushQueue != NULL && esp_now_init() == ESP_OK) {
+    esp_now_register_recv_cb(PushReceived);
+    uint32_t now    = time(NULL);
+    uint32_t oldest = now > PUSH_MIN_TIME ? max(PushLastSequence, now - PUSH_MAX_SKEW) : PushLastSequence;
+    PushAssembler* assembler = new PushAssembler((const uint8_t*)key, strlen(key), place, oldest); // Too large for the stack
+    Push_frame_type frame;
+    unsigned long start = millis();
+    while (!decoded && millis() - start < listen) {
+      if (xQueueReceive(PushQueue, &frame, pdMS_TO_TICKS(10)) != pdTRUE) continue;
+      Push_result_type result = assembler->Add(frame.Data, frame.Length);
+      if (result == PUSH_BAD_TAG) Serial.println("ESP-NOW frame failed authentication");
+      if (result != PUSH_COMPLETE) continue;
+      decoded = DecodeWire(assembler->Message(), assembler->Length());
+      if (!decoded) continue; // e.g. a gateway in other units, keep listening in case of a better one
+      PushLastSequence = assembler->Sequence();
+      if (PushLastSequence > PUSH_MIN_TIME) {
+        struct timeval now = {(time_t)PushLastSequence, 0};
+        settimeofday(&now, NULL);
+      }
+    }
+    delete assembler;
+    esp_now_unregister_recv_cb();
+    esp_now_deinit();
+  }
+  if (PushQueue != NULL) vQueueDelete(PushQueue);
+  PushQueue = NULL;
+  WiFi.mode(WIFI_OFF);
+  PhaseEnd(phase);
+  Serial.println(decoded ? "Forecast received by ESP-NOW" : "No forecast received by ESP-NOW");
+  return decoded;
+}
+//#########################################################################################
+// Broadcasts a message as frames on the channel WiFi is using, e.g. the access point's
+bool SendPush(const char* key, const uint8_t* message, size_t length, uint32_t place) {
+  if (length > PUSH_MAX_MESSAGE) return false;
+  static bool started = false;
+  if (!started) {
+    if (esp_now_init() != ESP_OK) return false;
+    esp_now_peer_info_t peer;
+    memset(&peer, 0, sizeof(peer));
+    memset(peer.peer_addr, 0xFF, ESP_NOW_ETH_ALEN); // Broadcast
+    peer.channel = 0;                               // The current channel
+    peer.ifidx   = WIFI_IF_STA;
+    if (esp_now_add_peer(&peer) != ESP_OK) return false;
+    started = true;
+  }
+  const uint8_t broadcast[ESP_NOW_ETH_ALEN] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  uint8_t  frame[PUSH_FRAME_SIZE];
+  uint32_t sequence = time(NULL);
+  bool     sent     = true;
+  for (int f = 0; f < PushFrameCount(length); f++) {
+    size_t size = PushFrame(frame, message, length, f, sequence, place, (const uint8_t*)key, strlen(key));
+    sent = esp_now_send(broadcast, frame, size) == ESP_OK && sent;
+    delay(2); // Lets each frame go before the next is queued
+  }
+  return sent;
+}
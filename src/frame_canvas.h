@@ -0,0 +1,20 @@
+//
+// Stands in for a GxEPD2 display when the sketch is built as a render server (see bitmap_codec.h), so the same
+// drawing code draws into a 1 bit canvas in memory, which is then sent to the panels instead of shown.
+
+#include <Adafruit_GFX.h>
+
+class FrameCanvas : public GFXcanvas1 {
+  public:
+    FrameCanvas(uint16_t width, uint16_t height) : GFXcanvas1(width, height) {}
+    template <typename... Args> void init(Args... args) {} // The GxEPD2 calls the sketch makes, which have nothing to drive
+    template <typename... Args> void writeImage(Args... args) {}
+    void setFullWindow() {}
+    void setPartialWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {}
+    void firstPage() {}
+    bool nextPage() { return false; } // The whole canvas is one page
+    void display(bool partial = false) {}
+    void refresh(bool partial = false) {}
+    void powerOff() {}
+    void hibernate() {}
+};
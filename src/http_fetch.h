@@ -0,0 +1,191 @@
+//
+// Fetch scheduler for sketches that need more than one HTTP resource per wake, e.g. weather and News.
+// Requests to the same host share one persistent (keep-alive) connection, requests to different hosts
+// run concurrently, each host in its own task, and every response body is streamed straight into its decoder.
+// Port 443 is fetched over TLS when FETCH_TLS is defined before including this, see tls_client.h. It's opt-in as
+// the TLS session cache takes a few KB of RTC memory in every sketch that includes it.
+// With FetchDeadline set, e.g. from an awake time budget, each request's timeouts end at it, and a job not started
+// by then isn't started at all.
+// Include after common.h, which provides the body streams.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#ifdef FETCH_TLS
+#include "tls_client.h"
+#endif
+
+#define FETCH_MAX_HOSTS   4      // Maximum number of different hosts fetched concurrently
+#define FETCH_TASK_STACK  16384  // Stack for each host task, the JSON decoders are recursive and TLS handshakes are deep
+#define FETCH_TIMEOUT     5000   // ms, HTTPClient's own connect and read timeouts
+#define FETCH_OVERDUE     -20    // HttpCode of a job not started as the deadline had passed
+
+typedef bool (*Fetch_decoder_type)(Stream& body, bool print);
+typedef void (*Fetch_store_type)(int tag);
+
+typedef struct { // One HTTP GET and the decoder its body is streamed into
+  String             Host;
+  uint16_t           Port;
+  String             Uri;
+  Fetch_decoder_type Decoder;
+  Fetch_decoder_type Fallback; // If set, the body is buffered and decoded again by this when Decoder fails
+  Fetch_store_type   Store;    // If set, called with Tag after a successful decode, e.g. to keep what the decoder left in its globals
+  int                Tag;
+  bool               Print;
+  int                HttpCode;
+  bool               Decoded;
+  unsigned long      Elapsed;
+} Fetch_job_type;
+
+typedef struct { // All the jobs for one host, fetched in order over a single connection
+  Fetch_job_type*   Jobs;
+  int               Count;
+  String            Host;
+  uint16_t          Port;
+  SemaphoreHandle_t Done;
+} Fetch_group_type;
+
+Fetch_job_type FetchJob(String host, uint16_t port, String uri, Fetch_decoder_type decoder, bool print);
+bool RunFetchJobs(Fetch_job_type jobs[], int count);
+void FetchHostGroup(Fetch_group_type* group);
+void FetchHostTask(void* parameter);
+bool FetchOne(WiFiClient& client, Fetch_job_type& job);
+long FetchTimeLeft();
+
+unsigned long FetchDeadline   = 0; // millis() by which fetches are to be done, 0 for no deadline
+int           FetchFailCode   = 0; // The last failed job's HttpCode and Retry-After secs, for a caller that only
+uint32_t      FetchRetryAfter = 0; // sees a count, e.g. RefreshLocations()
+
+//#########################################################################################
+Fetch_job_type FetchJob(String host, uint16_t port, String uri, Fetch_decoder_type decoder, bool print) {
+  Fetch_job_type job;
+  job.Host     = host;
+  job.Port     = port;
+  job.Uri      = uri;
+  job.Decoder  = decoder;
+  job.Fallback = NULL;
+  job.Store    = NULL;
+  job.Tag      = 0;
+  job.Print    = print;
+  job.HttpCode = 0;
+  job.Decoded  = false;
+  job.Elapsed  = 0;
+  return job;
+}
+//#########################################################################################
+// Returns true when every job was received and decoded. Each job records its own result, so a caller can
+// retry only the jobs that failed.
+bool RunFetchJobs(Fetch_job_type jobs[], int count) {
+  Fetch_group_type groups[FETCH_MAX_HOSTS];
+  int groupCount = 0;
+  unsigned long start = millis();
+  for (int j = 0; j < count; j++) {
+    int g = 0;
+    while (g < groupCount && !(groups[g].Host == jobs[j].Host && groups[g].Port == jobs[j].Port)) g++;
+    if (g == groupCount) {
+      if (groupCount == FETCH_MAX_HOSTS) {
+        Serial.println("Too many hosts to fetch, ignoring " + jobs[j].Host);
+        continue;
+      }
+      groups[g].Jobs  = jobs;
+      groups[g].Count = count;
+      groups[g].Host  = jobs[j].Host;
+      groups[g].Port  = jobs[j].Port;
+      groups[g].Done  = NULL;
+      groupCount++;
+    }
+  }
+  if (groupCount == 1) FetchHostGroup(&groups[0]); // Nothing to overlap with, so don't pay for a task
+  else {
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(groupCount, 0);
+    int started = 0;
+    for (int g = 0; g < groupCount; g++) {
+      groups[g].Done = done;
+      if (xTaskCreate(FetchHostTask, "fetch", FETCH_TASK_STACK, &groups[g], 1, NULL) == pdPASS) started++;
+      else FetchHostGroup(&groups[g]); // Not enough memory for another task, fetch this host in-line instead
+    }
+    for (int g = 0; g < started; g++) xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+  }
+  bool all = true;
+  for (int j = 0; j < count; j++) {
+    Serial.println("Fetched " + jobs[j].Host + " (" + String(jobs[j].HttpCode) + ") in " + String(jobs[j].Elapsed) + "-ms");
+    all = all && jobs[j].Decoded;
+  }
+  Serial.println("All fetches took " + String(millis() - start) + "-ms");
+  return all;
+}
+//#########################################################################################
+void FetchHostTask(void* parameter) {
+  Fetch_group_type* group = (Fetch_group_type*)parameter;
+  FetchHostGroup(group);
+  xSemaphoreGive(group->Done);
+  vTaskDelete(NULL);
+}
+//#########################################################################################
+void FetchHostGroup(Fetch_group_type* group) {
+  WiFiClient  plain;
+#ifdef FETCH_TLS
+  TlsClient   secure;
+  WiFiClient& client = group->Port == 443 ? secure : plain; // One connection for every request to this host
+  secure.SetHostname(group->Host.c_str());
+#else
+  WiFiClient& client = plain;
+  if (group->Port == 443) Serial.println("Define FETCH_TLS to fetch " + group->Host + " over HTTPS");
+#endif
+  for (int j = 0; j < group->Count; j++) {
+    Fetch_job_type& job = group->Jobs[j];
+    if (job.Host == group->Host && job.Port == group->Port) FetchOne(client, job);
+  }
+  client.stop();
+}
+//#########################################################################################
+bool FetchOne(WiFiClient& client, Fetch_job_type& job) {
+  unsigned long start = millis();
+  long left = FetchTimeLeft();
+  if (left <= 0) {
+    Serial.println("No time left to fetch " + job.Host + job.Uri);
+    job.HttpCode = FETCH_OVERDUE;
+    if (FetchFailCode == 0) FetchFailCode = FETCH_OVERDUE; // A failure that used the time up says more
+    return false;
+  }
+  HTTPClient http;
+  http.setReuse(true); // Ask for keep-alive, an already connected client is used without a new handshake
+  if (left < FETCH_TIMEOUT) {
+    http.setConnectTimeout(left);
+    http.setTimeout(left); // Each read of the body, so a slow body can still run over by a little
+  }
+  ConnectCached(client, job.Host.c_str(), job.Port);
+  http.begin(client, job.Host, job.Port, job.Uri);
+  PrepareBodyRequest(http);
+  job.HttpCode = http.GET();
+  if (job.HttpCode == HTTP_CODE_OK) {
+    HttpBodyStream body(http.getStream(), http.getSize(), ChunkedBody(http));
+    GzipStream     gzip(body);
+    Stream& json = GzipBody(http) ? (Stream&)gzip : (Stream&)body;
+    CpuWorkBegin(); // The decode, and with it the rest of the body's download, as it's streamed (see cpu_clock.h)
+    if (job.Fallback) {
+      Fetch_decoder_type decoders[] = {job.Decoder, job.Fallback};
+      job.Decoded = DecodeBufferedBody(json, GzipBody(http) ? -1 : http.getSize(), decoders, 2, job.Print);
+    }
+    else job.Decoded = job.Decoder(json, job.Print);
+    CpuWorkEnd();
+    if (!job.Decoded) FetchFailCode = job.HttpCode; // A 200 whose body didn't decode, see FetchFailure()
+    if (job.Decoded && job.Store) job.Store(job.Tag); // Before the next job on this connection decodes into the same globals
+    if (!body.Drain()) client.stop(); // Position in the stream is unknown, so the connection can't be reused
+  }
+  else {
+    Serial.printf("%s connection failed, code: %d %s\n", job.Host.c_str(), job.HttpCode, http.errorToString(job.HttpCode).c_str());
+    FetchFailCode   = job.HttpCode;
+    FetchRetryAfter = http.header("Retry-After").toInt(); // Seconds, an HTTP date reads as 0
+    client.stop();
+  }
+  http.end();
+  job.Elapsed = millis() - start;
+  return job.Decoded;
+}
+//#########################################################################################
+// Returns the ms left before FetchDeadline, or FETCH_TIMEOUT when there's none
+long FetchTimeLeft() {
+  return FetchDeadline == 0 ? FETCH_TIMEOUT : (long)(FetchDeadline - millis());
+}
@@ -0,0 +1,396 @@
+//
+// Response body streams shared by ReceiveOneCallWeather() and the fetch scheduler. HttpBodyStream removes the
+// HTTP framing, GzipStream inflates a gzip encoded body as it arrives, so a decoder can read either directly.
+// DecodeBufferedBody() instead reads the whole body into memory first, so a failed decode can be retried.
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/miniz.h"
+#elif CONFIG_IDF_TARGET_ESP32S2
+#include "esp32s2/rom/miniz.h"
+#elif CONFIG_IDF_TARGET_ESP32C3
+#include "esp32c3/rom/miniz.h"
+#else
+#include "esp32/rom/miniz.h"                // Inflater in the ESP32 ROM, so it costs no flash
+#endif
+
+#ifndef HTTP_ACCEPT_GZIP
+#define HTTP_ACCEPT_GZIP true               // Ask servers for a gzip compressed body, typically 5-8x fewer bytes on air
+#endif
+#define GZIP_INPUT_SIZE  512                // Compressed bytes read from the connection at a time
+#define HTTP_BUFFER_STEP        8192        // Growth of a body buffer when the length isn't known in advance
+#define HTTP_BUFFER_LIMIT       65536       // Largest body buffered in internal RAM
+#define HTTP_BUFFER_PSRAM_LIMIT 1048576     // and in PSRAM, when the board has it
+
+typedef bool (*Body_decoder_type)(Stream& body, bool print);
+
+//#########################################################################################
+// Presents only the body of a response to a decoder, removing chunked transfer framing and stopping at
+// Content-Length, so that the connection is left at the start of the next response and can be reused.
+class HttpBodyStream : public Stream {
+  public:
+    HttpBodyStream(Stream& source, int length, bool chunked)
+      : _source(source), _remaining(length), _chunked(chunked), _chunkLeft(0), _firstChunk(true), _peeked(-1), _done(length == 0 && !chunked) {
+      setTimeout(source.getTimeout());
+    }
+    int available() override {
+      if (_peeked >= 0) return 1;
+      if (_done) return 0;
+      int n = _source.available();
+      if (_chunked) return _chunkLeft > 0 && n > _chunkLeft ? _chunkLeft : n;
+      return _remaining >= 0 && n > _remaining ? _remaining : n;
+    }
+    int read() override {
+      if (_peeked >= 0) {
+        int c = _peeked;
+        _peeked = -1;
+        return c;
+      }
+      if (_done) return -1;
+      if (_chunked && _chunkLeft == 0 && !NextChunk()) return -1;
+      int c = SourceRead();
+      if (c < 0) return -1;
+      if (_chunked) _chunkLeft--;
+      else if (_remaining > 0 && --_remaining == 0) _done = true;
+      return c;
+    }
+    int peek() override {
+      if (_peeked < 0) _peeked = read();
+      return _peeked;
+    }
+    // Reads up-to the end of the chunk or of Content-Length from the connection at a time, rather than a byte per call
+    size_t readBytes(char* buffer, size_t length) override {
+      size_t got = 0;
+      if (length > 0 && _peeked >= 0) {
+        buffer[got++] = _peeked;
+        _peeked = -1;
+      }
+      while (got < length && !_done) {
+        if (_chunked && _chunkLeft == 0 && !NextChunk()) break;
+        size_t wanted = length - got;
+        if (_chunked) wanted = min(wanted, (size_t)_chunkLeft);
+        else if (_remaining >= 0) wanted = min(wanted, (size_t)_remaining);
+        size_t n = _source.readBytes(buffer + got, wanted);
+        got += n;
+        if (_chunked) _chunkLeft -= n;
+        else if (_remaining > 0 && (_remaining -= n) == 0) _done = true;
+        if (n < wanted) break; // Timed out
+      }
+      return got;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+    // Reads and discards whatever the decoder left unread, returns true if the body ended cleanly
+    // and the connection can carry another request
+    bool Drain() {
+      if (!_chunked && _remaining < 0) return false; // Body delimited by connection close
+      _peeked = -1;
+      while (read() >= 0) {}
+      return _done;
+    }
+  private:
+    int SourceRead() {
+      char c;
+      return _source.readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+    }
+    String SourceLine() {
+      String line = "";
+      int c;
+      while ((c = SourceRead()) >= 0 && c != '\n') if (c != '\r') line += (char)c;
+      return line;
+    }
+    bool NextChunk() {
+      if (!_firstChunk) SourceLine(); // CRLF that ends the previous chunk
+      _firstChunk = false;
+      _chunkLeft  = strtol(SourceLine().c_str(), NULL, 16);
+      if (_chunkLeft > 0) return true;
+      while (SourceLine().length() > 0) {} // Skip any trailers up to the final empty line
+      _done = true;
+      return false;
+    }
+    Stream& _source;
+    int     _remaining;
+    bool    _chunked;
+    int     _chunkLeft;
+    bool    _firstChunk;
+    int     _peeked;
+    bool    _done;
+};
+
+//#########################################################################################
+// Streaming gzip inflater. Deflate back-references reach up to 32 KB, so the output ring has to be one full
+// window (TINFL_LZ_DICT_SIZE), but that, the decompressor state and a small input buffer are allocated once on
+// first read and never grow, however long the body is. Nothing is buffered beyond what the decoder has not read yet.
+class GzipStream : public Stream {
+  public:
+    GzipStream(Stream& source)
+      : _source(source), _state(NULL), _started(false), _inputEnded(false), _done(false), _failed(false), _inPos(0), _inEnd(0), _inTotal(0), _outRead(0), _outWrite(0) {
+      setTimeout(source.getTimeout());
+    }
+    ~GzipStream() {
+      free(_state);
+    }
+    int available() override {
+      if (_outRead < _outWrite) return _outWrite - _outRead;
+      return _done || _failed ? 0 : _source.available() > 0;
+    }
+    int read() override {
+      if (_outRead == _outWrite && !Inflate()) return -1;
+      return _state->Dict[_outRead++ & (TINFL_LZ_DICT_SIZE - 1)];
+    }
+    int peek() override {
+      if (_outRead == _outWrite && !Inflate()) return -1;
+      return _state->Dict[_outRead & (TINFL_LZ_DICT_SIZE - 1)];
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+    size_t CompressedBytes() { return _inTotal; }
+    size_t InflatedBytes()   { return _outWrite; }
+  private:
+    typedef struct {
+      tinfl_decompressor Decompressor;
+      uint8_t            Dict[TINFL_LZ_DICT_SIZE];
+      uint8_t            In[GZIP_INPUT_SIZE];
+    } Inflate_state_type;
+    int SourceRead() {
+      char c;
+      if (_source.readBytes(&c, 1) != 1) return -1;
+      _inTotal++;
+      return (uint8_t)c;
+    }
+    bool SkipSource(int count) {
+      while (count-- > 0) if (SourceRead() < 0) return false;
+      return true;
+    }
+    bool SkipSourceString() { // Zero terminated file name or comment
+      int c;
+      while ((c = SourceRead()) > 0) {}
+      return c == 0;
+    }
+    bool Start() { // Allocates the inflater and consumes the gzip member header, RFC 1952
+      _started = true;
+      if (SourceRead() != 0x1f || SourceRead() != 0x8b || SourceRead() != 8) { // ID1, ID2 and CM = deflate
+        Serial.println("Gzip: not a gzip body");
+        return false;
+      }
+      int flags = SourceRead();
+      if (flags < 0 || !SkipSource(6)) return false; // MTIME, XFL and OS
+      if (flags & 0x04) { // FEXTRA
+        int lo = SourceRead(), hi = SourceRead();
+        if (lo < 0 || hi < 0 || !SkipSource(lo | (hi << 8))) return false;
+      }
+      if ((flags & 0x08) && !SkipSourceString()) return false; // FNAME
+      if ((flags & 0x10) && !SkipSourceString()) return false; // FCOMMENT
+      if ((flags & 0x02) && !SkipSource(2)) return false;      // FHCRC
+      _state = (Inflate_state_type*)malloc(sizeof(Inflate_state_type));
+      if (_state == NULL) {
+        Serial.println("Gzip: not enough memory to inflate");
+        return false;
+      }
+      tinfl_init(&_state->Decompressor);
+      return true;
+    }
+    void FillInput() {
+      int wanted = _source.available();
+      if (wanted <= 0) wanted = 1; // Nothing buffered yet, so wait (up to the timeout) for one byte
+      if (wanted > GZIP_INPUT_SIZE) wanted = GZIP_INPUT_SIZE;
+      _inPos = 0;
+      _inEnd = _source.readBytes(_state->In, wanted);
+      _inTotal += _inEnd;
+      if (_inEnd == 0) _inputEnded = true;
+    }
+    // Called only when everything inflated so far has been read, so the ring can be overwritten from the write position
+    bool Inflate() {
+      if (_done || _failed) return false;
+      if (!_started && !Start()) {
+        _failed = true;
+        return false;
+      }
+      while (true) {
+        if (_inPos == _inEnd && !_inputEnded) FillInput();
+        size_t inBytes  = _inEnd - _inPos;
+        size_t offset   = _outWrite & (TINFL_LZ_DICT_SIZE - 1);
+        size_t outBytes = TINFL_LZ_DICT_SIZE - offset;
+        tinfl_status status = tinfl_decompress(&_state->Decompressor, _state->In + _inPos, &inBytes, _state->Dict, _state->Dict + offset, &outBytes,
+                                               _inputEnded ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+        _inPos    += inBytes;
+        _outWrite += outBytes;
+        if (status == TINFL_STATUS_DONE) _done = true; // The 8 byte CRC32 and ISIZE trailer is left for the body stream to drain
+        else if (status < 0 || (status == TINFL_STATUS_NEEDS_MORE_INPUT && _inputEnded)) {
+          Serial.println("Gzip: inflate failed, status " + String((int)status));
+          _failed = true;
+        }
+        if (outBytes > 0) return true;
+        if (_done || _failed) return false;
+      }
+    }
+    Stream&             _source;
+    Inflate_state_type* _state;
+    bool                _started;
+    bool                _inputEnded;
+    bool                _done;
+    bool                _failed;
+    size_t              _inPos;
+    size_t              _inEnd;
+    size_t              _inTotal;
+    size_t              _outRead;
+    size_t              _outWrite;
+};
+
+//#########################################################################################
+// Ends a body after a fixed number of bytes, so that however long a response is, decoding it takes bounded time
+class LimitedStream : public Stream {
+  public:
+    LimitedStream(Stream& source, size_t limit) : _source(source), _left(limit) {
+      setTimeout(source.getTimeout());
+    }
+    int available() override { return min((size_t)max(_source.available(), 0), _left); }
+    int read() override {
+      if (_left == 0) return -1;
+      int c = _source.read();
+      if (c >= 0) _left--;
+      return c;
+    }
+    int peek() override { return _left > 0 ? _source.peek() : -1; }
+    size_t readBytes(char* buffer, size_t length) override { // Returns at once at the limit, rather than after the stream timeout
+      if (_left == 0) return 0;
+      size_t got = _source.readBytes(buffer, min(length, _left));
+      _left -= got;
+      return got;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+    bool Exhausted() { return _left == 0; } // Limit reached, so the body may have been cut short
+  private:
+    Stream& _source;
+    size_t  _left;
+};
+
+//#########################################################################################
+// Reads from a body held in memory, so that the same body can be decoded more than once
+class BufferStream : public Stream {
+  public:
+    BufferStream(const uint8_t* buffer, size_t size) : _buffer(buffer), _size(size), _position(0) {}
+    int available() override { return _size - _position; }
+    int read() override { return _position < _size ? _buffer[_position++] : -1; }
+    int peek() override { return _position < _size ? _buffer[_position] : -1; }
+    size_t readBytes(char* buffer, size_t length) override {
+      length = min(length, _size - _position);
+      memcpy(buffer, _buffer + _position, length);
+      _position += length;
+      return length;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+  private:
+    const uint8_t* _buffer;
+    size_t         _size;
+    size_t         _position;
+};
+//#########################################################################################
+// The start of a body already read into memory followed by the rest of it from the connection, so a body too large
+// to buffer can still be decoded as it arrives
+class PrefixedStream : public Stream {
+  public:
+    PrefixedStream(const uint8_t* buffer, size_t size, Stream& rest) : _prefix(buffer, size), _rest(rest) {
+      setTimeout(rest.getTimeout());
+    }
+    int available() override { return _prefix.available() > 0 ? _prefix.available() : _rest.available(); }
+    int read() override { return _prefix.available() > 0 ? _prefix.read() : _rest.read(); }
+    int peek() override { return _prefix.available() > 0 ? _prefix.peek() : _rest.peek(); }
+    size_t readBytes(char* buffer, size_t length) override {
+      size_t got = _prefix.readBytes(buffer, length);
+      return got < length ? got + _rest.readBytes(buffer + got, length - got) : got;
+    }
+    size_t write(uint8_t) override { return 0; }
+    void flush() override {}
+  private:
+    BufferStream _prefix;
+    Stream&      _rest;
+};
+
+void     PrepareBodyRequest(HTTPClient& http);
+bool     ChunkedBody(HTTPClient& http);
+bool     GzipBody(HTTPClient& http);
+uint8_t* ReadBody(Stream& body, int length, size_t& size, bool* truncated = NULL);
+bool     DecodeBufferedBody(Stream& body, int length, Body_decoder_type decoders[], int count, bool print);
+
+//#########################################################################################
+// Call between http.begin() and http.GET(), so the response headers that ChunkedBody() and GzipBody() need are kept,
+// and Retry-After for a backoff (see backoff.h)
+void PrepareBodyRequest(HTTPClient& http) {
+  const char* headerKeys[] = {"Transfer-Encoding", "Content-Encoding", "Retry-After"};
+  if (HTTP_ACCEPT_GZIP) http.addHeader("Accept-Encoding", "gzip");
+  http.collectHeaders(headerKeys, 3);
+}
+//#########################################################################################
+bool ChunkedBody(HTTPClient& http) {
+  return http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+}
+//#########################################################################################
+bool GzipBody(HTTPClient& http) {
+  return http.header("Content-Encoding").equalsIgnoreCase("gzip");
+}
+//#########################################################################################
+// Reads the whole body into one buffer, in PSRAM when there is some. length is the Content-Length, or -1 when it
+// isn't known e.g. for a chunked or gzip body, then the buffer grows as the body arrives. Returns NULL, having
+// read nothing, if the body is known to be too large to buffer. When an unknown length body outgrows the limit, or
+// memory runs out, the buffer holds the start of it and *truncated is set, the rest is left to be read.
+uint8_t* ReadBody(Stream& body, int length, size_t& size, bool* truncated) {
+  bool   psram    = psramFound();
+  size_t limit    = psram ? HTTP_BUFFER_PSRAM_LIMIT : HTTP_BUFFER_LIMIT;
+  size_t capacity = length > 0 ? length : HTTP_BUFFER_STEP;
+  size = 0;
+  if (truncated) *truncated = false;
+  if (capacity > limit) return NULL;
+  uint8_t* buffer = (uint8_t*)(psram ? ps_malloc(capacity) : malloc(capacity));
+  while (buffer != NULL) {
+    if (size == capacity) {
+      if (length > 0) break;                      // Whole body
+      size_t   grown  = min(capacity * 2, limit);
+      uint8_t* larger = NULL;
+      if (grown > capacity) larger = (uint8_t*)(psram ? ps_realloc(buffer, grown) : realloc(buffer, grown));
+      if (larger == NULL) {                       // Can't keep any more, the rest is still to come
+        if (body.peek() < 0) break;               // unless the body ended at exactly this size
+        if (truncated) *truncated = true;
+        break;
+      }
+      capacity = grown;
+      buffer   = larger;
+    }
+    int c = body.read();                          // Waits for each byte, so -1 is the end of the body
+    if (c < 0) break;
+    buffer[size++] = c;
+  }
+  return buffer;
+}
+//#########################################################################################
+// Decodes a body held in memory with each decoder in turn until one succeeds, so a decoder that fails e.g. for lack
+// of memory for its document can be followed by a leaner one, without fetching the body again. When the body can't
+// be buffered, it's decoded as it arrives by the first decoder alone, after the part already read if it outgrew the
+// buffer part way through.
+bool DecodeBufferedBody(Stream& body, int length, Body_decoder_type decoders[], int count, bool print) {
+  size_t   size;
+  bool     truncated;
+  uint8_t* buffer = ReadBody(body, length, size, &truncated);
+  if (buffer == NULL) {
+    Serial.println("Body not buffered, decoding it as it arrives");
+    return decoders[0](body, print);
+  }
+  if (truncated) {
+    Serial.println("Body larger than the " + String(size) + " byte buffer, decoding the rest as it arrives");
+    PrefixedStream json(buffer, size, body);
+    bool decoded = decoders[0](json, print);
+    free(buffer);
+    return decoded;
+  }
+  bool decoded = false;
+  for (int d = 0; d < count && !decoded; d++) {
+    if (d > 0) Serial.println("Retrying decode of the buffered " + String(size) + " byte body");
+    BufferStream json(buffer, size);
+    decoded = decoders[d](json, print);
+  }
+  free(buffer);
+  return decoded;
+}
@@ -0,0 +1,107 @@
+//
+// Several locations on one display, e.g. a lobby showing each site in turn. The forecast for each location is kept
+// in RTC memory in the wire format (see wire_format.h) without its texts, so LoadLocation() restores every field the
+// display uses. RefreshLocations() fetches the wanted locations whose record is too old, all of them over one
+// keep-alive connection. The panel sketches show one location per wake and so fetch only that one, one One Call
+// request per wake however many locations there are, while a LAN gateway fetches all of its locations together.
+// Include after common.h, http_fetch.h and wire_format.h, and define max_readings as for common.h.
+
+#include <Arduino.h>
+#include "time.h"
+
+#define LOCATION_MAX       4     // Locations kept across deep-sleep
+#define LOCATION_WIRE_SIZE 800   // Bytes kept of each forecast, about 650 are used, so four locations take about 3.2k of RTC memory
+#define LOCATION_MAX_STALE 21600 // secs, an older record isn't shown when its location can't be fetched
+#define LOCATION_ATTEMPTS  2     // Fetches of each location per wake
+#define LOCATION_JITTER    250   // ms, a retry waits a random time up-to this, doubled for each attempt, so panels that failed together retry apart
+
+typedef struct {
+  String Name;
+  String Lat;
+  String Lon;
+} Location_type;
+
+typedef struct {
+  uint32_t Place;   // Hash of the coordinates, units and language fetched, so an edited location isn't shown stale data
+  uint32_t Fetched; // Unix time, 0 if never
+  uint16_t Size;    // of the forecast in Wire
+  uint8_t  Wire[LOCATION_WIRE_SIZE]; // WxConditions, WxForecast and Daily in the wire format, without the texts
+} Location_record_type;
+
+RTC_DATA_ATTR Location_record_type LocationRecords[LOCATION_MAX];
+RTC_DATA_ATTR uint8_t              LocationNext = 0;
+
+int      NextLocation(int count);
+int      RefreshLocations(Location_type locations[], const int wanted[], int count, uint32_t maxAge, bool print);
+bool     LocationFresh(Location_type& location, int l, uint32_t maxAge);
+bool     LoadLocation(int l);
+void     StoreLocation(int l);
+uint32_t LocationPlace(const Location_type& location);
+
+//#########################################################################################
+// Returns the location to show on this wake, each in turn
+int NextLocation(int count) {
+  int l = LocationNext % count;
+  LocationNext = (l + 1) % count;
+  return l;
+}
+//#########################################################################################
+// Fetches each wanted location whose record is older than maxAge secs, then returns how many of the wanted
+// locations have a record that can be shown, even if it couldn't be refreshed.
+int RefreshLocations(Location_type locations[], const int wanted[], int count, uint32_t maxAge, bool print) {
+  Fetch_job_type jobs[LOCATION_MAX];
+  int jobCount = 0;
+  for (int w = 0; w < count && jobCount < LOCATION_MAX; w++) {
+    int l = wanted[w];
+    if (LocationFresh(locations[l], l, maxAge)) continue;
+    jobs[jobCount] = FetchJob(server, OWM_PORT, OneCallUri(locations[l].Lat, locations[l].Lon), DecodeOneCallWeather, print);
+    jobs[jobCount].Store = StoreLocation;
+    jobs[jobCount].Tag   = l;
+    jobCount++;
+  }
+  for (int attempt = 0; attempt < LOCATION_ATTEMPTS && jobCount > 0 && FetchTimeLeft() > 0; attempt++) {
+    if (attempt > 0) delay(min((long)(esp_random() % (LOCATION_JITTER << attempt)), FetchTimeLeft() / 2));
+    Serial.println("Rx weather data for " + String(jobCount) + " location(s)...");
+    RunFetchJobs(jobs, jobCount); // Every job is for the same host, so they share one connection
+    int failed = 0;
+    for (int j = 0; j < jobCount; j++) {
+      if (jobs[j].Decoded) LocationRecords[jobs[j].Tag].Place = LocationPlace(locations[jobs[j].Tag]);
+      else {
+        jobs[failed] = jobs[j]; // Retry only the locations that failed
+        jobs[failed].HttpCode = 0;
+        failed++;
+      }
+    }
+    jobCount = failed;
+  }
+  int ready = 0;
+  for (int w = 0; w < count; w++) {
+    if (LocationFresh(locations[wanted[w]], wanted[w], LOCATION_MAX_STALE)) ready++;
+  }
+  return ready;
+}
+//#########################################################################################
+// True when the record holds this location and was fetched less than maxAge secs ago
+bool LocationFresh(Location_type& location, int l, uint32_t maxAge) {
+  Location_record_type& record = LocationRecords[l];
+  return record.Place == LocationPlace(location) && record.Fetched != 0 && (uint32_t)time(NULL) - record.Fetched < maxAge;
+}
+//#########################################################################################
+// Unpacks a location's record into WxConditions, WxForecast and Daily, for the display. Every field the wire format
+// carries is set, and the descriptions are cleared, as the record doesn't keep them.
+bool LoadLocation(int l) {
+  Location_record_type& record = LocationRecords[l];
+  return record.Fetched != 0 && DecodeWire(record.Wire, record.Size);
+}
+//#########################################################################################
+// Packs what the One Call decoder left in WxConditions, WxForecast and Daily into a location's record
+void StoreLocation(int l) {
+  Location_record_type& record = LocationRecords[l];
+  record.Size    = EncodeWire(record.Wire, sizeof(record.Wire), false);
+  record.Fetched = record.Size > 0 ? time(NULL) : 0;
+  if (record.Size == 0) Serial.println("Forecast too large for a location record, LOCATION_WIRE_SIZE is " + String(LOCATION_WIRE_SIZE));
+}
+//#########################################################################################
+uint32_t LocationPlace(const Location_type& location) {
+  return HostHash((location.Lat + "," + location.Lon + "," + Units + "," + Language).c_str());
+}
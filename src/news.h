@@ -0,0 +1,87 @@
+//
+// News headline decoder for newsapi.org 'top-headlines' responses. Only the title and source name of each
+// article are kept, in a fixed-capacity buffer, so memory use doesn't depend on the length of the feed. A text
+// too long for its buffer is cut at the last whole UTF-8 character that fits, so the display isn't sent half of one.
+// Include after common.h, which provides LimitedStream.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define NEWS_MAX_HEADLINES 10  // Headlines kept, any further articles are skipped
+#define NEWS_TITLE_SIZE    160 // Longer titles are truncated
+#define NEWS_SOURCE_SIZE   32
+#define NEWS_MAX_BODY      65536 // Bytes read at most, bounds the time spent on a malformed or hostile response
+#define NEWS_MAX_DEPTH     6
+
+typedef struct {
+  char Title[NEWS_TITLE_SIZE];
+  char Source[NEWS_SOURCE_SIZE];
+} News_headline_type;
+
+News_headline_type Headlines[NEWS_MAX_HEADLINES];
+int                HeadlineCount = 0;
+
+bool   DecodeNewsHeadlines(Stream& json, bool print);
+int    NewsPeek(LimitedStream& json);
+size_t CopyUtf8(char* buffer, const char* text, size_t size);
+
+//#########################################################################################
+// Rather than building the whole response, seek to the 'articles' array and deserialise one article at a time
+// through a filter, so only one title and source name are ever held in the JsonDocument.
+bool DecodeNewsHeadlines(Stream& body, bool print) {
+  HeadlineCount = 0;
+  LimitedStream json(body, NEWS_MAX_BODY);
+  if (!json.find("\"articles\"") || !json.find("[")) {
+    Serial.println("News: no articles in response");
+    return false;
+  }
+  int next;
+  while ((next = NewsPeek(json)) == ' ' || next == '\t' || next == '\r' || next == '\n') json.read();
+  if (next == ']') {
+    if (print) Serial.println("News: no headlines");
+    return true; // No news is a valid response
+  }
+  JsonDocument filter;
+  filter["title"]          = true;
+  filter["source"]["name"] = true;
+  JsonDocument article;
+  do {
+    DeserializationError error = deserializeJson(article, json, DeserializationOption::Filter(filter), DeserializationOption::NestingLimit(NEWS_MAX_DEPTH));
+    if (error) {
+      Serial.print(F("News deserializeJson() failed: "));
+      Serial.println(error.c_str());
+      return HeadlineCount > 0;
+    }
+    News_headline_type& headline = Headlines[HeadlineCount];
+    CopyUtf8(headline.Title,  article["title"] | "",          sizeof(headline.Title));
+    CopyUtf8(headline.Source, article["source"]["name"] | "", sizeof(headline.Source));
+    if (print) Serial.println(String(HeadlineCount + 1) + " : " + String(headline.Title));
+    HeadlineCount++;
+  } while (HeadlineCount < NEWS_MAX_HEADLINES && json.findUntil(",", "]"));
+  return true;
+}
+//#########################################################################################
+// Waits up-to the stream's timeout for the next character without taking it, -1 if there's none
+int NewsPeek(LimitedStream& json) {
+  unsigned long start = millis();
+  int c;
+  while ((c = json.peek()) < 0 && !json.Exhausted() && millis() - start < json.getTimeout()) delay(1);
+  return c;
+}
+//#########################################################################################
+// Copies text into a buffer of size bytes, and if it doesn't fit, cuts it back to the end of the last whole
+// UTF-8 character, returns the bytes kept
+size_t CopyUtf8(char* buffer, const char* text, size_t size) {
+  size_t length = strlcpy(buffer, text, size);
+  if (length < size) return length;
+  size_t end   = size - 1;
+  size_t start = end; // Start of the last character kept, after any continuation bytes
+  while (start > 0 && ((uint8_t)buffer[start - 1] & 0xC0) == 0x80) start--;
+  if (start > 0) {
+    uint8_t lead  = buffer[start - 1];
+    size_t  bytes = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (end - (start - 1) < bytes) end = start - 1; // Its last bytes didn't fit
+  }
+  buffer[end] = 0;
+  return end;
+}
@@ -0,0 +1,292 @@
+//
+// Streaming parser for One Call 3.0 responses, an alternative to building an ArduinoJson document. Values are
+// written into WxConditions, WxForecast and Daily as their keys are recognised, with no intermediate document,
+// so memory use is fixed and doesn't depend on the size of the response. Select it by defining
+// ONECALL_STREAM_PARSER before including common.h, which includes this file after the forecast records.
+
+#include <Arduino.h>
+#include <limits>
+
+// Hard limits for both One Call decoders, so the worst case decode time and memory are fixed whatever is received
+#define ONECALL_MAX_BODY     65536 // Bytes, a response is typically 20-35 KB and anything longer is rejected
+#define ONECALL_MAX_DEPTH    8     // Deepest One Call value is 4 levels down, e.g. daily[0].temp.max
+#define ONECALL_MAX_ELEMENTS 256   // Longest array, 'minutely' has 61 entries and 'hourly' 48
+#define ONECALL_TOKEN_SIZE   160   // Longer strings e.g. a daily summary are truncated
+
+enum OneCall_key_type : uint8_t {
+  KEY_OTHER, KEY_TIMEZONE_OFFSET, KEY_CURRENT, KEY_HOURLY, KEY_DAILY, KEY_WEATHER, KEY_DESCRIPTION, KEY_ICON,
+  KEY_SUNRISE, KEY_SUNSET, KEY_TEMP, KEY_FEELS_LIKE, KEY_PRESSURE, KEY_HUMIDITY, KEY_DEW_POINT, KEY_UVI,
+  KEY_CLOUDS, KEY_VISIBILITY, KEY_WIND_SPEED, KEY_WIND_DEG, KEY_DT, KEY_RAIN, KEY_SNOW, KEY_1H, KEY_SUMMARY,
+  KEY_DAY, KEY_MAX, KEY_MIN, KEY_POP, KEY_COUNT
+};
+
+const char* const OneCallKeys[KEY_COUNT] = {
+  "", "timezone_offset", "current", "hourly", "daily", "weather", "description", "icon",
+  "sunrise", "sunset", "temp", "feels_like", "pressure", "humidity", "dew_point", "uvi",
+  "clouds", "visibility", "wind_speed", "wind_deg", "dt", "rain", "snow", "1h", "summary",
+  "day", "max", "min", "pop"
+};
+
+typedef struct {
+  bool     Array;
+  uint8_t  Key;   // Key of the value being parsed, for an object
+  uint16_t Index; // Index of the value being parsed, for an array
+} OneCall_frame_type;
+
+//#########################################################################################
+// Returns a JSON number as a T, clamped to T's range, as converting one out of range, e.g. 1e300 into an int, is
+// undefined, and NaN as 0
+template <typename T> T NumberAs(double value) {
+  if (isnan(value)) return 0;
+  return (T)constrain(value, (double)std::numeric_limits<T>::lowest(), (double)std::numeric_limits<T>::max());
+}
+//#########################################################################################
+class OneCallParser {
+  public:
+    OneCallParser(Stream& json) : _json(json), _pending(-1), _depth(0), _fields(0), _error("") {}
+    bool Parse() {
+      ClearRecords();
+      int c = SkipSpace();
+      if (c != '{') return Fail("not a JSON object");
+      Push(false);
+      while (_depth > 0) {
+        c = SkipSpace();
+        if (c < 0) return Fail("truncated");
+        OneCall_frame_type& frame = _frames[_depth - 1];
+        if (c == '}' || c == ']') {
+          if (c != (frame.Array ? ']' : '}')) return Fail("mismatched bracket");
+          _depth--;
+          continue;
+        }
+        if (c == ',') {
+          if (frame.Array && ++frame.Index == ONECALL_MAX_ELEMENTS) return Fail("array too long");
+          continue;
+        }
+        if (!frame.Array) { // A key, then the value it names
+          if (c != '"' || !ReadString()) return Fail("expected a key");
+          frame.Key = FindKey(_token);
+          if (SkipSpace() != ':') return Fail("expected ':'");
+          c = SkipSpace();
+        }
+        if (c == '{' || c == '[') {
+          if (_depth == ONECALL_MAX_DEPTH) return Fail("too deeply nested");
+          Push(c == '[');
+        }
+        else if (c == '"') {
+          if (!ReadString()) return Fail("unterminated string");
+          AssignString();
+        }
+        else if (c == '-' || isdigit(c)) {
+          if (!ReadNumber(c)) return Fail("bad number");
+          AssignNumber(strtod(_token, NULL));
+        }
+        else if (!ReadLiteral(c)) return Fail("unexpected character");
+      }
+      return true;
+    }
+    const char* Error()  { return _error; }
+    int         Fields() { return _fields; }
+  private:
+    int Next() { // Next byte, waiting for it as deserializeJson() does
+      if (_pending >= 0) {
+        int c = _pending;
+        _pending = -1;
+        return c;
+      }
+      int c = _json.read();
+      if (c >= 0) return c;
+      uint8_t b;
+      return _json.readBytes(&b, 1) == 1 ? b : -1;
+    }
+    int SkipSpace() {
+      int c;
+      do c = Next(); while (c == ' ' || c == '\n' || c == '\r' || c == '\t');
+      return c;
+    }
+    void Push(bool array) {
+      _frames[_depth].Array = array;
+      _frames[_depth].Key   = KEY_OTHER;
+      _frames[_depth].Index = 0;
+      _depth++;
+    }
+    bool Fail(const char* error) {
+      _error = error;
+      return false;
+    }
+    uint8_t FindKey(const char* key) {
+      for (uint8_t k = 1; k < KEY_COUNT; k++) if (strcmp(key, OneCallKeys[k]) == 0) return k;
+      return KEY_OTHER;
+    }
+    bool ReadString() { // Opening quote already read
+      int length = 0;
+      int c;
+      while ((c = Next()) != '"') {
+        if (c < 0) return false;
+        if (c == '\\') {
+          c = Next();
+          switch (c) {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u': {
+              uint32_t code = ReadHex();
+              if (code >= 0xD800 && code < 0xDC00 && Next() == '\\' && Next() == 'u') code = 0x10000 + ((code - 0xD800) << 10) + (ReadHex() - 0xDC00);
+              length = AppendUtf8(length, code);
+              continue;
+            }
+            default: if (c < 0) return false; // '"', '\\' and '/' stand for themselves
+          }
+        }
+        if (length < ONECALL_TOKEN_SIZE - 1) _token[length++] = c;
+      }
+      _token[length] = '\0';
+      return true;
+    }
+    uint32_t ReadHex() {
+      uint32_t code = 0;
+      for (int i = 0; i < 4; i++) {
+        int c = Next();
+        code = code << 4 | (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10) & 0x0F);
+      }
+      return code;
+    }
+    int AppendUtf8(int length, uint32_t code) {
+      uint8_t bytes[4];
+      int count;
+      if (code < 0x80)         { bytes[0] = code; count = 1; }
+      else if (code < 0x800)   { bytes[0] = 0xC0 | code >> 6;  bytes[1] = 0x80 | (code & 0x3F); count = 2; }
+      else if (code < 0x10000) { bytes[0] = 0xE0 | code >> 12; bytes[1] = 0x80 | (code >> 6 & 0x3F); bytes[2] = 0x80 | (code & 0x3F); count = 3; }
+      else { bytes[0] = 0xF0 | code >> 18; bytes[1] = 0x80 | (code >> 12 & 0x3F); bytes[2] = 0x80 | (code >> 6 & 0x3F); bytes[3] = 0x80 | (code & 0x3F); count = 4; }
+      if (length + count >= ONECALL_TOKEN_SIZE) return length;
+      memcpy(_token + length, bytes, count);
+      return length + count;
+    }
+    bool ReadNumber(int c) {
+      int length = 0;
+      while (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || isdigit(c)) {
+        if (length == 31) return false;
+        _token[length++] = c;
+        c = Next();
+      }
+      _token[length] = '\0';
+      _pending = c; // The delimiter belongs to the enclosing object or array
+      return true;
+    }
+    bool ReadLiteral(int c) { // true, false and null don't set any field, as the records are already cleared
+      const char* literal = c == 't' ? "rue" : c == 'f' ? "alse" : c == 'n' ? "ull" : NULL;
+      if (literal == NULL) return false;
+      while (*literal) if (Next() != *literal++) return false;
+      return true;
+    }
+    // Finds the record a value belongs to and the position of its key below the record, e.g. 2 for daily[r].temp.max
+    Forecast_record_type* Record(uint8_t& section, int& level) {
+      section = _frames[0].Key;
+      if (section == KEY_CURRENT && _depth >= 2) {
+        level = 1;
+        return &WxConditions[0];
+      }
+      if (_depth < 3 || !_frames[1].Array) return NULL;
+      level = 2;
+      if (section == KEY_HOURLY && _frames[1].Index < max_readings) return &WxForecast[_frames[1].Index];
+      if (section == KEY_DAILY  && _frames[1].Index < 8)            return &Daily[_frames[1].Index];
+      return NULL;
+    }
+    void AssignNumber(double value) {
+      if (_depth == 1) {
+        if (_frames[0].Key == KEY_TIMEZONE_OFFSET) Set(WxConditions[0].Timezone, value);
+        return;
+      }
+      uint8_t section;
+      int     level;
+      Forecast_record_type* record = Record(section, level);
+      if (record == NULL) return;
+      uint8_t key = _frames[level].Key;
+      if (_depth == level + 1) {
+        switch (key) {
+          case KEY_DT:         if (section != KEY_CURRENT) Set(record->Dt, value); break;
+          case KEY_TEMP:       if (section != KEY_DAILY)   Set(record->Temperature, value); break;
+          case KEY_FEELS_LIKE: if (section != KEY_DAILY)   Set(record->FeelsLike, value); break;
+          case KEY_PRESSURE:   if (section != KEY_DAILY)   Set(record->Pressure, value); break;
+          case KEY_HUMIDITY:   Set(record->Humidity, value); break;
+          case KEY_DEW_POINT:  if (section != KEY_DAILY)   Set(record->DewPoint, value); break;
+          case KEY_UVI:        if (section != KEY_HOURLY)  Set(record->UVI, value); break;
+          case KEY_RAIN:       if (section == KEY_DAILY)   Set(record->Rainfall, value); break;
+          case KEY_SNOW:       if (section == KEY_DAILY)   Set(record->Snowfall, value); break;
+          case KEY_POP:        if (section != KEY_CURRENT) Set(record->PoP, value); break;
+        }
+        if (section != KEY_CURRENT) return;
+        switch (key) {
+          case KEY_SUNRISE:    Set(record->Sunrise, value); break;
+          case KEY_SUNSET:     Set(record->Sunset, value); break;
+          case KEY_CLOUDS:     Set(record->Cloudcover, value); break;
+          case KEY_VISIBILITY: Set(record->Visibility, value); break;
+          case KEY_WIND_SPEED: Set(record->Windspeed, value); break;
+          case KEY_WIND_DEG:   Set(record->Winddir, value); break;
+        }
+        return;
+      }
+      if (_depth != level + 2 || _frames[level + 1].Array) return;
+      uint8_t sub = _frames[level + 1].Key;
+      if (section == KEY_HOURLY && sub == KEY_1H) {
+        if (key == KEY_RAIN) Set(record->Rainfall, value);
+        if (key == KEY_SNOW) Set(record->Snowfall, value);
+      }
+      if (section == KEY_DAILY && key == KEY_TEMP) {
+        if (sub == KEY_DAY) Set(record->Temperature, value);
+        if (sub == KEY_MAX) Set(record->High, value);
+        if (sub == KEY_MIN) Set(record->Low, value);
+      }
+    }
+    void AssignString() {
+      uint8_t section;
+      int     level;
+      Forecast_record_type* record = Record(section, level);
+      if (record == NULL) return;
+      uint8_t key = _frames[level].Key;
+      if (_depth == level + 1) {
+        if (section == KEY_DAILY && key == KEY_SUMMARY) Set(record->Description, _token);
+        return;
+      }
+      // Only the first weather condition is used, weather[0].icon and for current conditions weather[0].description
+      if (key != KEY_WEATHER || _depth != level + 3 || !_frames[level + 1].Array || _frames[level + 1].Index != 0) return;
+      uint8_t sub = _frames[level + 2].Key;
+      if (sub == KEY_ICON) Set(record->Icon, _token);
+      if (sub == KEY_DESCRIPTION && section == KEY_CURRENT) Set(record->Description, _token);
+    }
+    template <typename T> void Set(T& field, double value) {
+      field = NumberAs<T>(value);
+      _fields++;
+    }
+    void Set(String& field, const char* value) {
+      field = value;
+      _fields++;
+    }
+    void ClearRecords() { // Fields missing from the response read as 0 or "", as they do from a JsonDocument
+      Forecast_record_type& current = WxConditions[0];
+      current.Timezone = current.Sunrise = current.Sunset = current.Cloudcover = current.Visibility = 0;
+      current.Temperature = current.FeelsLike = current.Pressure = current.Humidity = current.DewPoint = current.UVI = 0;
+      current.Windspeed = current.Winddir = 0;
+      current.Description = current.Icon = "";
+      for (int r = 0; r < max_readings; r++) {
+        Forecast_record_type& hourly = WxForecast[r];
+        hourly.Dt = 0;
+        hourly.Temperature = hourly.FeelsLike = hourly.Pressure = hourly.Humidity = hourly.DewPoint = hourly.PoP = hourly.Rainfall = hourly.Snowfall = 0;
+        hourly.Icon = "";
+      }
+      for (int r = 0; r < 8; r++) {
+        Forecast_record_type& daily = Daily[r];
+        daily.Dt = 0;
+        daily.Temperature = daily.High = daily.Low = daily.Humidity = daily.PoP = daily.UVI = daily.Rainfall = daily.Snowfall = 0;
+        daily.Description = daily.Icon = "";
+      }
+    }
+    Stream&            _json;
+    int                _pending;
+    int                _depth;
+    int                _fields;
+    const char*        _error;
+    OneCall_frame_type _frames[ONECALL_MAX_DEPTH];
+    char               _token[ONECALL_TOKEN_SIZE];
+};
@@ -0,0 +1,88 @@
+//
+// Refresh schedule, a few rules each giving the days, the time window and the interval to update the display at, e.g.
+//   Schedule_rule_type Schedule[] = {
+//     {SCHEDULE_WEEKDAYS, 7 * 60, 18 * 60, 15}, // Every 15 minutes 07:00 to 18:00 Monday to Friday
+//     {SCHEDULE_WEEKEND,  8 * 60, 22 * 60, 60}, // Hourly 08:00 to 22:00 at the weekend, and never overnight
+//   };
+// Updates are at Start, Start + Interval, ... up-to but not including End, in local time, so NextScheduledWake()
+// gives the exact time of the next one, and a panel sleeps once until it rather than waking through the night.
+// Times are made with mktime(), so a window keeps its local times across a DST change.
+
+#include <Arduino.h>
+#include "time.h"
+
+#define SCHEDULE_SUNDAY    0x01 // Days, as tm_wday bits
+#define SCHEDULE_MONDAY    0x02
+#define SCHEDULE_TUESDAY   0x04
+#define SCHEDULE_WEDNESDAY 0x08
+#define SCHEDULE_THURSDAY  0x10
+#define SCHEDULE_FRIDAY    0x20
+#define SCHEDULE_SATURDAY  0x40
+#define SCHEDULE_WEEKDAYS  0x3E
+#define SCHEDULE_WEEKEND   0x41
+#define SCHEDULE_EVERY_DAY 0x7F
+#define SCHEDULE_MIN_TIME  1600000000 // A clock before this hasn't been set
+
+typedef struct {
+  uint8_t Days;     // SCHEDULE_ bits
+  int     Start;    // Minutes after midnight
+  int     End;      // Minutes after midnight, up-to 24 * 60
+  int     Interval; // Minutes
+} Schedule_rule_type;
+
+time_t NextScheduledWake(const Schedule_rule_type rules[], int count, time_t now);
+bool   InSchedule(const Schedule_rule_type rules[], int count, time_t now);
+time_t ScheduleTime(const struct tm& day, int minutes);
+
+//#########################################################################################
+// Returns the first update time after now, or 0 if the clock isn't set or no rule has an update in the next week
+time_t NextScheduledWake(const Schedule_rule_type rules[], int count, time_t now) {
+  if (now < SCHEDULE_MIN_TIME) return 0;
+  struct tm today;
+  localtime_r(&now, &today);
+  time_t next = 0;
+  for (int d = 0; d <= 7 && next == 0; d++) { // Later days can only be later, so stop at the first day with an update
+    struct tm day = today;
+    day.tm_mday += d;
+    day.tm_hour  = 12; // Midday, which no DST change moves to another day
+    day.tm_min   = 0;
+    day.tm_sec   = 0;
+    day.tm_isdst = -1;
+    time_t noon = mktime(&day);
+    localtime_r(&noon, &day);
+    for (int r = 0; r < count; r++) {
+      const Schedule_rule_type& rule = rules[r];
+      if (!(rule.Days & (1 << day.tm_wday)) || rule.Interval <= 0) continue;
+      for (int m = rule.Start; m < rule.End; m += rule.Interval) {
+        time_t slot = ScheduleTime(day, m);
+        if (slot <= now) continue;
+        if (next == 0 || slot < next) next = slot;
+        break; // The rest of this rule's updates today are later
+      }
+    }
+  }
+  return next;
+}
+//#########################################################################################
+// True when now is within the window of a rule for today, i.e. an update is due about now
+bool InSchedule(const Schedule_rule_type rules[], int count, time_t now) {
+  if (now < SCHEDULE_MIN_TIME) return false;
+  struct tm local;
+  localtime_r(&now, &local);
+  int minutes = local.tm_hour * 60 + local.tm_min;
+  for (int r = 0; r < count; r++) {
+    if ((rules[r].Days & (1 << local.tm_wday)) && minutes >= rules[r].Start && minutes < rules[r].End) return true;
+  }
+  return false;
+}
+//#########################################################################################
+// Returns the time minutes after midnight on day, in local time. A time the clocks skip comes out an hour later, and
+// one they repeat, as whichever of the two mktime() chooses, so each is used once.
+time_t ScheduleTime(const struct tm& day, int minutes) {
+  struct tm slot = day;
+  slot.tm_hour  = minutes / 60;
+  slot.tm_min   = minutes % 60;
+  slot.tm_sec   = 0;
+  slot.tm_isdst = -1;
+  return mktime(&slot);
+}
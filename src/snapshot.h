@@ -0,0 +1,67 @@
+//
+// Forecast snapshots, a location's record (see locations.h) as served by a LAN gateway (see examples/LAN_Gateway),
+// so many panels share one One Call request and each receives about 650 bytes instead of the JSON.
+// The gateway answers GET /snapshot?lat=51.38&lon=-2.36 for each location in its list with the forecast in the wire
+// format (see wire_format.h) and an Age header of the secs since it was fetched, as an HTTP cache does. The wire
+// format is laid out byte by byte, and carries its version, units and a CRC, so the two ends needn't be built
+// alike, and anything that can write it can be a gateway.
+// Include after locations.h.
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+
+#define SNAPSHOT_PORT    8080
+#define SNAPSHOT_PATH    "/snapshot"
+#define SNAPSHOT_TIMEOUT 2000       // ms, a gateway is on the LAN, so give up quickly and fetch from OWM instead
+
+bool   ReceiveSnapshot(WiFiClient& client, const char* gateway, Location_type& location, int l);
+bool   StoreSnapshot(Stream& body, int length, uint32_t age, Location_type& location, int l);
+String SnapshotUri(const Location_type& location);
+
+//#########################################################################################
+// Receives the snapshot of a location from a gateway into its record, returns false if the gateway doesn't
+// answer, doesn't have the location, or its snapshot can't be used, so the caller can fetch from OWM instead.
+bool ReceiveSnapshot(WiFiClient& client, const char* gateway, Location_type& location, int l) {
+  int phase = PhaseBegin("Gateway snapshot");
+  const char* headerKeys[] = {"Age"};
+  HTTPClient http;
+  http.setConnectTimeout(SNAPSHOT_TIMEOUT);
+  http.setTimeout(SNAPSHOT_TIMEOUT);
+  http.begin(client, gateway, SNAPSHOT_PORT, SnapshotUri(location));
+  http.collectHeaders(headerKeys, 1);
+  int httpCode = http.GET();
+  bool received = false;
+  if (httpCode == HTTP_CODE_OK) {
+    http.getStream().setTimeout(SNAPSHOT_TIMEOUT);
+    received = StoreSnapshot(http.getStream(), http.getSize(), http.header("Age").toInt(), location, l);
+  }
+  else Serial.printf("Gateway %s gave no snapshot, code: %d\n", gateway, httpCode);
+  http.end();
+  client.stop();
+  PhaseEnd(phase);
+  return received;
+}
+//#########################################################################################
+// Reads a snapshot body of length bytes, fetched age secs ago, into the location's record if it's a complete and
+// undamaged forecast of this wire format version in the units in use, otherwise leaves the record as it was.
+bool StoreSnapshot(Stream& body, int length, uint32_t age, Location_type& location, int l) {
+  uint8_t data[LOCATION_WIRE_SIZE];
+  if (length <= 0 || length > LOCATION_WIRE_SIZE || age >= LOCATION_MAX_STALE) {
+    Serial.println("Gateway snapshot of " + String(length) + " bytes, " + String(age) + "-secs old, can't be used");
+    return false;
+  }
+  if (body.readBytes(data, length) != (size_t)length || !CheckWire(data, length)) {
+    Serial.println("Gateway snapshot is incomplete or from a different version");
+    return false;
+  }
+  Location_record_type& record = LocationRecords[l];
+  memcpy(record.Wire, data, length);
+  record.Size    = length;
+  record.Fetched = time(NULL) - age;
+  record.Place   = LocationPlace(location); // The gateway's hash covers its own language setting
+  return true;
+}
+//#########################################################################################
+String SnapshotUri(const Location_type& location) {
+  return String(SNAPSHOT_PATH) + "?lat=" + location.Lat + "&lon=" + location.Lon;
+}
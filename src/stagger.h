@@ -0,0 +1,30 @@
+//
+// Fleet staggering, so a floor of panels on the same schedule doesn't wake in the same second, all join the access
+// point together and then all ask OWM for a forecast together. Each panel moves its updates later by an offset
+// of its own, from a hash of its MAC address, so the fleet spreads out across the spread while each panel still
+// updates at the same minute past every scheduled time, wake after wake. With a schedule (see schedule.h):
+//   Stagger = StaggerOffset(SleepDuration * 60);
+//   wake    = NextScheduledWake(Schedule, count, now - Stagger) + Stagger; // The times the schedule gives, moved later
+//   InSchedule(Schedule, count, now - Stagger);
+// Retries within a wake are spread as well, see RefreshLocations().
+
+#include <Arduino.h>
+
+#define STAGGER_STEP 5 // secs, offsets are a multiple of this, so a panel's update time reads as a round time
+
+uint32_t StaggerOffset(uint32_t spread);
+
+//#########################################################################################
+// Returns this panel's offset in secs, from 0 up-to but not including spread
+uint32_t StaggerOffset(uint32_t spread) {
+  uint64_t mac = ESP.getEfuseMac();
+  mac ^= mac >> 33; // A 64-bit finaliser, so panels with consecutive MAC addresses get unrelated offsets
+  mac *= 0xff51afd7ed558ccdULL;
+  mac ^= mac >> 33;
+  mac *= 0xc4ceb9fe1a85ec53ULL;
+  mac ^= mac >> 33;
+  uint32_t steps  = max(spread / STAGGER_STEP, (uint32_t)1);
+  uint32_t offset = (mac % steps) * STAGGER_STEP;
+  Serial.println("Updates staggered by " + String(offset) + "-secs");
+  return offset;
+}
@@ -0,0 +1,381 @@
+//
+// HTTPS client for the weather fetch. It is a WiFiClient, so HTTPClient and ReceiveOneCallWeather() use it unchanged.
+// The server is authenticated by pinning the SHA-256 fingerprint of its certificate instead of validating the
+// certificate chain, a host with no pin is refused, and the TLS session is kept in RTC memory so the next wake resumes it with an abbreviated
+// handshake rather than paying for a full one (1-2 secs of CPU and several KB of heap on an ESP32).
+// Sessions are serialised with the server's certificate when the IDF's mbedtls keeps it (MBEDTLS_SSL_KEEP_PEER_CERTIFICATE,
+// on by default), so each RTC slot is sized for that, and a session that still doesn't fit is logged and not kept.
+// Include after common.h, which provides the wake phase timing and HostHash(). http_fetch.h includes it when FETCH_TLS is defined.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include "mbedtls/version.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/md.h"
+#include "mbedtls/net_sockets.h"
+
+#define TLS_CACHED_HOSTS      2     // Hosts whose sessions are kept across deep sleep
+#ifndef TLS_SESSION_SIZE
+#if defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+#define TLS_SESSION_SIZE      2816  // Serialised session incl. ticket and the peer certificate, up to ~2.4 KB for an RSA-4096 one
+#else
+#define TLS_SESSION_SIZE      768   // Serialised session incl. ticket
+#endif
+#endif
+#define TLS_MAX_PINS          4
+#define TLS_HANDSHAKE_TIMEOUT 10000 // ms
+
+typedef struct {
+  uint32_t HostHash;
+  uint16_t Length;
+  uint8_t  Data[TLS_SESSION_SIZE];
+} Tls_session_type;
+
+typedef struct {
+  uint32_t HostHash;
+  uint8_t  Fingerprint[32];
+} Tls_pin_type;
+
+RTC_DATA_ATTR Tls_session_type TlsSessions[TLS_CACHED_HOSTS];
+RTC_DATA_ATTR uint8_t          TlsNextSession = 0;
+Tls_pin_type                   TlsPins[TLS_MAX_PINS];
+int                            TlsPinCount = 0;
+
+bool     SetTlsPin(const char* host, const char* fingerprint);
+int      TlsSend(void* context, const unsigned char* buffer, size_t length);
+int      TlsReceive(void* context, unsigned char* buffer, size_t length);
+
+//#########################################################################################
+class TlsClient : public WiFiClient {
+  public:
+    TlsClient() : _tls(NULL), _socket(-1), _peeked(-1), _verified(false) {}
+    ~TlsClient() {
+      stop();
+    }
+    // Name sent as SNI and used to find the pin and cached session when connecting by IP address
+    void SetHostname(const char* host) {
+      _host = host;
+    }
+    int connect(IPAddress ip, uint16_t port) {
+      return connect(ip, port, TLS_HANDSHAKE_TIMEOUT);
+    }
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) {
+      return Open(ip, port, timeout);
+    }
+    int connect(const char* host, uint16_t port) {
+      return connect(host, port, TLS_HANDSHAKE_TIMEOUT);
+    }
+    int connect(const char* host, uint16_t port, int32_t timeout) {
+      IPAddress ip;
+      _host = host;
+      if (!WiFi.hostByName(host, ip)) return 0;
+      return Open(ip, port, timeout);
+    }
+    size_t write(uint8_t c) {
+      return write(&c, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) {
+      if (!_tls) return 0;
+      size_t sent = 0;
+      unsigned long start = millis();
+      while (sent < size) {
+        int ret = mbedtls_ssl_write(&_tls->Ssl, buffer + sent, size - sent);
+        if (ret > 0) sent += ret;
+        else if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) || millis() - start > _timeout) break;
+        else delay(1);
+      }
+      return sent;
+    }
+    int available() {
+      if (_peeked >= 0) return 1 + (_tls ? mbedtls_ssl_get_bytes_avail(&_tls->Ssl) : 0);
+      if (!_tls) return 0;
+      int buffered = mbedtls_ssl_get_bytes_avail(&_tls->Ssl);
+      if (buffered > 0) return buffered;
+      return peek() >= 0 ? 1 : 0; // Nothing decrypted yet, so try to read a record
+    }
+    int read() {
+      uint8_t c;
+      return read(&c, 1) == 1 ? c : -1;
+    }
+    int read(uint8_t* buffer, size_t size) {
+      if (size == 0) return 0;
+      int got = 0;
+      if (_peeked >= 0) {
+        buffer[got++] = _peeked;
+        _peeked = -1;
+        if (got == (int)size) return got;
+      }
+      if (!_tls) return got > 0 ? got : -1;
+      int ret = ReadRecord(buffer + got, size - got);
+      if (ret > 0) return got + ret;
+      if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) Ended();
+      return got > 0 ? got : -1;
+    }
+    int peek() {
+      if (_peeked < 0 && _tls) {
+        uint8_t c;
+        int ret = ReadRecord(&c, 1);
+        if (ret == 1) _peeked = c;
+        else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) Ended();
+      }
+      return _peeked;
+    }
+    void flush() {}
+    uint8_t connected() {
+      return _tls != NULL || _peeked >= 0;
+    }
+    operator bool() {
+      return connected();
+    }
+    void stop() {
+      if (_tls && _verified) SaveSession();
+      if (_tls) mbedtls_ssl_close_notify(&_tls->Ssl);
+      Close();
+      _peeked = -1;
+    }
+  private:
+    typedef struct {
+      mbedtls_ssl_context      Ssl;
+      mbedtls_ssl_config       Config;
+      mbedtls_entropy_context  Entropy;
+      mbedtls_ctr_drbg_context Drbg;
+    } Tls_context_type;
+    int Open(IPAddress ip, uint16_t port, int32_t timeout) {
+      stop();
+      int phase = PhaseBegin("TCP connect");
+      bool opened = OpenSocket(ip, port, timeout);
+      PhaseEnd(phase);
+      if (!opened) {
+        Serial.println("TLS: TCP connection to " + _host + " failed");
+        Close();
+        return 0;
+      }
+      _tls = (Tls_context_type*)calloc(1, sizeof(Tls_context_type)); // On the heap, as the fetch tasks have small stacks
+      if (_tls == NULL) {
+        Close();
+        return 0;
+      }
+      mbedtls_ssl_init(&_tls->Ssl);
+      mbedtls_ssl_config_init(&_tls->Config);
+      mbedtls_entropy_init(&_tls->Entropy);
+      mbedtls_ctr_drbg_init(&_tls->Drbg);
+      if (mbedtls_ctr_drbg_seed(&_tls->Drbg, mbedtls_entropy_func, &_tls->Entropy, NULL, 0) != 0 ||
+          mbedtls_ssl_config_defaults(&_tls->Config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        Close();
+        return 0;
+      }
+      mbedtls_ssl_conf_authmode(&_tls->Config, MBEDTLS_SSL_VERIFY_NONE); // The certificate pin replaces chain validation
+      mbedtls_ssl_conf_rng(&_tls->Config, mbedtls_ctr_drbg_random, &_tls->Drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+      mbedtls_ssl_conf_session_tickets(&_tls->Config, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+      if (mbedtls_ssl_setup(&_tls->Ssl, &_tls->Config) != 0 || mbedtls_ssl_set_hostname(&_tls->Ssl, _host.c_str()) != 0) {
+        Close();
+        return 0;
+      }
+      mbedtls_ssl_set_bio(&_tls->Ssl, &_socket, TlsSend, TlsReceive, NULL);
+      bool offered = LoadSession();
+      phase = PhaseBegin(offered ? "TLS handshake (resume)" : "TLS handshake (full)");
+      unsigned long start = millis();
+      int ret;
+      CpuWorkBegin(); // The key exchange is most of a wake's computing
+      _resumed = false;
+      while ((ret = Handshake()) != 0) {
+        if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) || millis() - start > TLS_HANDSHAKE_TIMEOUT) {
+          CpuWorkEnd();
+          Serial.printf("TLS: handshake with %s failed, error -0x%04x\n", _host.c_str(), -ret);
+          if (offered) ForgetSession(); // The server may have dropped it, so start afresh next time
+          Close();
+          return 0;
+        }
+        delay(1);
+      }
+      CpuWorkEnd();
+      PhaseEnd(phase);
+      Serial.println("TLS: " + String(Resumed() ? "resumed" : "full") + " handshake with " + _host + " took " + String(millis() - start) + "-ms");
+      if (!VerifyPin(offered)) {
+        Close();
+        return 0;
+      }
+      return 1;
+    }
+    // Steps the handshake on 2.x, as it has no mbedtls_ssl_session_reused(), to see if the client goes straight from the
+    // ServerHello to the server's ChangeCipherSpec, as it only does when the server took up the session or ticket offered
+    int Handshake() {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+      return mbedtls_ssl_handshake(&_tls->Ssl);
+#else
+      while (_tls->Ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        int state = _tls->Ssl.state;
+        int ret   = mbedtls_ssl_handshake_step(&_tls->Ssl);
+        if (state == MBEDTLS_SSL_SERVER_HELLO && _tls->Ssl.state == MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC) _resumed = true;
+        if (ret != 0) return ret;
+      }
+      return 0;
+#endif
+    }
+    bool OpenSocket(IPAddress ip, uint16_t port, int32_t timeout) {
+      _socket = lwip_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+      if (_socket < 0) return false;
+      fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL, 0) | O_NONBLOCK);
+      struct sockaddr_in address;
+      memset(&address, 0, sizeof(address));
+      address.sin_family      = AF_INET;
+      address.sin_addr.s_addr = (uint32_t)ip;
+      address.sin_port        = htons(port);
+      if (lwip_connect(_socket, (struct sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) return false;
+      fd_set writable;
+      FD_ZERO(&writable);
+      FD_SET(_socket, &writable);
+      struct timeval wait = {timeout / 1000, (timeout % 1000) * 1000};
+      if (lwip_select(_socket + 1, NULL, &writable, NULL, &wait) <= 0) return false;
+      int error = 0;
+      socklen_t length = sizeof(error);
+      lwip_getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &length);
+      return error == 0;
+    }
+    int ReadRecord(uint8_t* buffer, size_t size) {
+      int ret;
+      do ret = mbedtls_ssl_read(&_tls->Ssl, buffer, size);
+#ifdef MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET
+      while (ret == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET); // A TLS 1.3 ticket after the handshake, the data follows it
+#else
+      while (false);
+#endif
+      return ret;
+    }
+    void Ended() { // Peer closed the connection or it failed
+      if (_tls && _verified) SaveSession();
+      Close();
+    }
+    void Close() {
+      if (_tls) {
+        mbedtls_ssl_free(&_tls->Ssl);
+        mbedtls_ssl_config_free(&_tls->Config);
+        mbedtls_ctr_drbg_free(&_tls->Drbg);
+        mbedtls_entropy_free(&_tls->Entropy);
+        free(_tls);
+        _tls = NULL;
+      }
+      if (_socket >= 0) lwip_close(_socket);
+      _socket   = -1;
+      _verified = false;
+    }
+    bool VerifyPin(bool offered) {
+      uint32_t hash = HostHash(_host.c_str());
+      const Tls_pin_type* pin = NULL;
+      for (int p = 0; p < TlsPinCount; p++) if (TlsPins[p].HostHash == hash) pin = &TlsPins[p];
+      if (pin == NULL) Serial.println("TLS: no pin set for " + _host + ", the connection is refused as the server can't be authenticated");
+      const mbedtls_x509_crt* cert = mbedtls_ssl_get_peer_cert(&_tls->Ssl);
+      if (cert == NULL) { // Resumed sessions only carry the certificate if the IDF keeps it, and were only cached once pinned
+        _verified = pin != NULL && offered && Resumed();
+        if (!_verified) Serial.println("TLS: no certificate from " + _host + " to check against its pin");
+        return _verified;
+      }
+      uint8_t fingerprint[32];
+      mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), cert->raw.p, cert->raw.len, fingerprint);
+      if (pin != NULL && memcmp(fingerprint, pin->Fingerprint, sizeof(fingerprint)) == 0) {
+        _verified = true;
+        return true;
+      }
+      char hex[65];
+      for (int i = 0; i < 32; i++) sprintf(hex + 2 * i, "%02x", fingerprint[i]);
+      if (pin != NULL) Serial.println("TLS: certificate of " + _host + " does not match its pin, fingerprint is " + String(hex));
+      else             Serial.println("TLS: fingerprint of " + _host + " is " + String(hex) + ", pin it with SetTlsPin() once checked");
+      return false;
+    }
+    // True if the server took up the session offered, rather than making a full handshake
+    bool Resumed() {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+      return _tls != NULL && mbedtls_ssl_session_reused(&_tls->Ssl) == 1;
+#else
+      return _resumed;
+#endif
+    }
+    Tls_session_type* FindSession() {
+      uint32_t hash = HostHash(_host.c_str());
+      for (int s = 0; s < TLS_CACHED_HOSTS; s++) if (TlsSessions[s].HostHash == hash && TlsSessions[s].Length > 0) return &TlsSessions[s];
+      return NULL;
+    }
+    bool LoadSession() {
+      Tls_session_type* cached = FindSession();
+      if (cached == NULL) return false;
+      mbedtls_ssl_session session;
+      mbedtls_ssl_session_init(&session);
+      bool loaded = mbedtls_ssl_session_load(&session, cached->Data, cached->Length) == 0 && mbedtls_ssl_set_session(&_tls->Ssl, &session) == 0;
+      mbedtls_ssl_session_free(&session);
+      if (!loaded) cached->Length = 0;
+      return loaded;
+    }
+    void ForgetSession() {
+      Tls_session_type* cached = FindSession();
+      if (cached != NULL) cached->Length = 0;
+    }
+    // Saved when the connection ends rather than after the handshake, as a TLS 1.3 ticket only arrives afterwards
+    void SaveSession() {
+      Tls_session_type* cached = FindSession();
+      if (cached == NULL) {
+        cached = &TlsSessions[TlsNextSession];
+        TlsNextSession = (TlsNextSession + 1) % TLS_CACHED_HOSTS;
+      }
+      mbedtls_ssl_session session;
+      mbedtls_ssl_session_init(&session);
+      size_t length = 0;
+      cached->Length = 0;
+      int ret = mbedtls_ssl_get_session(&_tls->Ssl, &session);
+      if (ret == 0) ret = mbedtls_ssl_session_save(&session, cached->Data, TLS_SESSION_SIZE, &length);
+      if (ret == 0) {
+        cached->HostHash = HostHash(_host.c_str());
+        cached->Length   = length;
+      }
+      else if (ret == MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        Serial.println("TLS: session for " + _host + " needs " + String(length) + " bytes, more than TLS_SESSION_SIZE (" + String(TLS_SESSION_SIZE) + "), so isn't kept");
+      }
+      else Serial.printf("TLS: session for %s can't be kept, error -0x%04x\n", _host.c_str(), -ret);
+      mbedtls_ssl_session_free(&session);
+    }
+    Tls_context_type* _tls;
+    int               _socket;
+    int               _peeked;
+    bool              _verified;
+    bool              _resumed = false; // Taken up by the server, on 2.x
+    String            _host;
+};
+
+//#########################################################################################
+// Fingerprint is the SHA-256 of the server certificate as hex, separators such as ':' or ' ' are ignored.
+// A host with no pin is refused, and its fingerprint printed, so it can be checked and pinned.
+bool SetTlsPin(const char* host, const char* fingerprint) {
+  if (TlsPinCount == TLS_MAX_PINS) return false;
+  Tls_pin_type& pin = TlsPins[TlsPinCount];
+  int digits = 0;
+  for (const char* c = fingerprint; *c && digits < 64; c++) {
+    if (!isxdigit(*c)) continue;
+    int value = isdigit(*c) ? *c - '0' : (tolower(*c) - 'a' + 10);
+    if (digits % 2 == 0) pin.Fingerprint[digits / 2] = value << 4;
+    else pin.Fingerprint[digits / 2] |= value;
+    digits++;
+  }
+  if (digits != 64) {
+    Serial.println("TLS: pin for " + String(host) + " is not a SHA-256 fingerprint");
+    return false;
+  }
+  pin.HostHash = HostHash(host);
+  TlsPinCount++;
+  return true;
+}
+//#########################################################################################
+int TlsSend(void* context, const unsigned char* buffer, size_t length) {
+  int sent = lwip_send(*(int*)context, buffer, length, 0);
+  if (sent >= 0) return sent;
+  return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+//#########################################################################################
+int TlsReceive(void* context, unsigned char* buffer, size_t length) {
+  int got = lwip_recv(*(int*)context, buffer, length, 0);
+  if (got >= 0) return got; // 0 is an orderly close by the peer
+  return errno == EAGAIN || errno == EWOULDBLOCK ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+}
@@ -0,0 +1,92 @@
+//
+// Awake time budget, so a bad WiFi day costs a few seconds a wake rather than the sum of every timeout. Each phase
+// has a deadline in ms since boot, and the last of them is the budget for the wake, e.g. 8 seconds in all:
+//   Budget_type Budget = {4000, 5000, 8000}; // WiFi joined, clock set, forecast fetched
+// A phase that overruns is cut short, and the wake goes on with what it has: the forecast kept in RTC memory is
+// shown with a stale marker, or if there's none, or no clock, the display isn't refreshed. The panel refresh
+// itself isn't budgeted, the processor sleeps through it (see busy_sleep.h). The outcome of each wake, and the
+// phases that overran, are kept in RTC memory and printed before sleeping.
+
+#include <Arduino.h>
+
+#define BUDGET_HISTORY 8 // Wakes
+
+#define BUDGET_WIFI  0x01 // Phases, as overrun bits
+#define BUDGET_CLOCK 0x02
+#define BUDGET_FETCH 0x04
+
+enum budget_outcome {BUDGET_FRESH, BUDGET_STALE, BUDGET_SKIPPED};
+
+typedef struct {
+  unsigned long WiFi;  // ms since boot by which each phase is to be done
+  unsigned long Clock;
+  unsigned long Fetch;
+} Budget_type;
+
+typedef struct {
+  uint32_t Time;     // Unix time of the wake, 0 if not known
+  uint16_t Awake;    // ms since boot when the outcome was known, i.e. before the display refresh
+  uint8_t  Outcome;
+  uint8_t  Overruns; // Phase bits
+} Budget_record_type;
+
+RTC_DATA_ATTR Budget_record_type BudgetRecords[BUDGET_HISTORY];
+RTC_DATA_ATTR uint32_t           BudgetCount = 0;
+RTC_DATA_ATTR uint32_t           BudgetTotals[3]; // Wakes with each outcome since power on
+uint8_t BudgetOverruns = 0;
+
+unsigned long BudgetLeft(unsigned long deadline);
+void          BudgetDelay(Budget_type& budget, unsigned long ms);
+bool          BudgetCheck(uint8_t phase, unsigned long deadline);
+void          BudgetRecord(int outcome);
+void          PrintBudget();
+
+//#########################################################################################
+// Returns the ms left before deadline, 0 once it has passed
+unsigned long BudgetLeft(unsigned long deadline) {
+  unsigned long now = millis();
+  return now < deadline ? deadline - now : 0;
+}
+//#########################################################################################
+// Moves every deadline ms later, for time spent before the budgeted phases start, e.g. listening for an ESP-NOW
+// push (see espnow_push.h), so it isn't taken from the time WiFi has to join
+void BudgetDelay(Budget_type& budget, unsigned long ms) {
+  budget.WiFi  += ms;
+  budget.Clock += ms;
+  budget.Fetch += ms;
+}
+//#########################################################################################
+// Returns true while phase is within its deadline, otherwise records the overrun
+bool BudgetCheck(uint8_t phase, unsigned long deadline) {
+  if (millis() < deadline) return true;
+  if (!(BudgetOverruns & phase)) Serial.println("Over budget at " + String(millis()) + "-ms, phase due by " + String(deadline) + "-ms");
+  BudgetOverruns |= phase;
+  return false;
+}
+//#########################################################################################
+// Call once a wake, when it's known what will be shown
+void BudgetRecord(int outcome) {
+  time_t now = time(NULL);
+  Budget_record_type& record = BudgetRecords[BudgetCount++ % BUDGET_HISTORY];
+  record.Time     = now > 1600000000 ? now : 0;
+  record.Awake    = min(millis(), 65535UL);
+  record.Outcome  = outcome;
+  record.Overruns = BudgetOverruns;
+  BudgetTotals[outcome]++;
+}
+//#########################################################################################
+void PrintBudget() {
+  const char* outcomes[] = {"fresh", "stale", "skipped"};
+  Serial.println("Wake budget, " + String(BudgetTotals[BUDGET_FRESH]) + " fresh, " + String(BudgetTotals[BUDGET_STALE]) + " stale, " +
+                 String(BudgetTotals[BUDGET_SKIPPED]) + " skipped since power on, the last:");
+  for (uint32_t w = BudgetCount > BUDGET_HISTORY ? BudgetCount - BUDGET_HISTORY : 0; w < BudgetCount; w++) {
+    Budget_record_type& record = BudgetRecords[w % BUDGET_HISTORY];
+    time_t    time = record.Time;
+    struct tm local;
+    char      when[20] = "time unknown";
+    if (time != 0 && localtime_r(&time, &local)) strftime(when, sizeof(when), "%d %b %H:%M", &local);
+    Serial.printf("  %-12s %-7s awake %5u-ms%s%s%s\n", when, outcomes[record.Outcome], record.Awake,
+                  record.Overruns & BUDGET_WIFI ? ", WiFi over" : "", record.Overruns & BUDGET_CLOCK ? ", clock over" : "",
+                  record.Overruns & BUDGET_FETCH ? ", fetch over" : "");
+  }
+}
@@ -0,0 +1,50 @@
+//
+// Wake cycle metrics, records how long each phase of a wake took so the cost of e.g. a TLS handshake shows up
+// in the serial log, with the CPU clock each began at (see cpu_clock.h). Phases may be recorded from the fetch tasks
+// as well as from setup().
+
+#include <Arduino.h>
+
+#define METRICS_MAX_PHASES 24
+
+typedef struct {
+  const char*   Name;
+  unsigned long Start;   // ms since boot
+  unsigned long Elapsed; // ms
+  uint16_t      MHz;
+} Phase_record_type;
+
+Phase_record_type Phases[METRICS_MAX_PHASES];
+int               PhaseCount = 0;
+portMUX_TYPE      PhaseLock  = portMUX_INITIALIZER_UNLOCKED;
+
+int  PhaseBegin(const char* name);
+void PhaseEnd(int phase);
+void PrintPhases();
+
+//#########################################################################################
+// Returns the phase number to pass to PhaseEnd(), or -1 when the table is full
+int PhaseBegin(const char* name) {
+  int phase = -1;
+  portENTER_CRITICAL(&PhaseLock);
+  if (PhaseCount < METRICS_MAX_PHASES) phase = PhaseCount++;
+  portEXIT_CRITICAL(&PhaseLock);
+  if (phase < 0) return -1;
+  Phases[phase].Name    = name;
+  Phases[phase].Start   = millis();
+  Phases[phase].Elapsed = 0;
+  Phases[phase].MHz     = getCpuFrequencyMhz();
+  return phase;
+}
+//#########################################################################################
+void PhaseEnd(int phase) {
+  if (phase < 0) return;
+  Phases[phase].Elapsed = millis() - Phases[phase].Start;
+}
+//#########################################################################################
+void PrintPhases() {
+  Serial.println("Wake cycle phases:");
+  for (int p = 0; p < PhaseCount; p++) {
+    Serial.printf("  %-24s start %6lu-ms took %6lu-ms at %3uMHz\n", Phases[p].Name, Phases[p].Start, Phases[p].Elapsed, Phases[p].MHz);
+  }
+}
@@ -0,0 +1,68 @@
+//
+// Deep sleep wake stub, so the timer wakes that fall in quiet hours, outside WakeupTime to SleepTime, go straight
+// back to sleep from RTC memory instead of booting the sketch, starting WiFi and getting the time only to find it's
+// too early to update the display. Before it sleeps, the sketch works out how many of its wakes are before
+// WakeupTime and leaves the count in RTC memory for the stub, which counts them down:
+//   QuietWakes  = QuietWakesBefore(WakeupTime, SleepTime, SleepTimer, SleepDuration * 60);
+//   QuietPeriod = SleepDuration * 60 * 1000000ULL;
+// The stub needs ESP-IDF 5 (Arduino-ESP32 3.x) for esp_wake_stub.h, on earlier versions every wake boots as before.
+// For a sketch that wakes every SleepDuration, e.g. Waveshare_7_5_News, one on a schedule (see schedule.h) sleeps
+// straight to its next update.
+
+#include <Arduino.h>
+#include "esp_sleep.h"
+#include "time.h"
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include "esp_wake_stub.h"
+#endif
+
+#define STUB_MIN_TIME 1600000000 // A clock before this hasn't been set, so there's no telling when the quiet hours are
+
+RTC_DATA_ATTR uint32_t QuietWakes  = 0; // Timer wakes the stub is to sleep through before the sketch boots again
+RTC_DATA_ATTR uint64_t QuietPeriod = 0; // us between them
+RTC_DATA_ATTR uint32_t QuietSlept  = 0; // Wakes slept through since the sketch last booted
+
+int  QuietWakesBefore(int wakeupHour, int sleepHour, long sleepTimer, long period);
+void PrintQuietWakes();
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+//#########################################################################################
+// Runs from RTC memory on every wake from deep sleep, before the sketch is loaded, so it can only use RTC memory
+// and the esp_wake_stub functions
+void RTC_IRAM_ATTR esp_wake_deep_sleep(void) {
+  esp_default_wake_deep_sleep();
+  if (QuietWakes == 0) return; // Boot the sketch
+  QuietWakes--;
+  QuietSlept++;
+  esp_wake_stub_set_wakeup_time(QuietPeriod);
+  esp_wake_stub_sleep(&esp_wake_deep_sleep);
+}
+#endif
+//#########################################################################################
+// Returns how many wakes, period seconds apart from the first in sleepTimer seconds, come before wakeupHour, when
+// the first of them is in the quiet hours, or 0 when it's within wakeupHour to sleepHour or the time isn't known
+int QuietWakesBefore(int wakeupHour, int sleepHour, long sleepTimer, long period) {
+  time_t now = time(NULL);
+  if (now < STUB_MIN_TIME || period <= 0) return 0;
+  time_t    next = now + sleepTimer;
+  struct tm wake;
+  localtime_r(&next, &wake);
+  if (wake.tm_hour >= wakeupHour && wake.tm_hour <= sleepHour) return 0; // That wake updates the display
+  struct tm morning = wake;
+  morning.tm_hour  = wakeupHour;
+  morning.tm_min   = 0;
+  morning.tm_sec   = 0;
+  morning.tm_isdst = -1; // mktime() works it out, so a DST change overnight is allowed for
+  time_t until = mktime(&morning);
+  if (until < next) { // It's before midnight, so the morning is tomorrow's
+    morning.tm_mday++;
+    morning.tm_isdst = -1;
+    until = mktime(&morning);
+  }
+  return (until - next + period - 1) / period;
+}
+//#########################################################################################
+void PrintQuietWakes() {
+  if (QuietSlept > 0) Serial.println("Wake stub slept through " + String(QuietSlept) + " quiet hours wake(s)");
+  QuietSlept = 0;
+}
@@ -0,0 +1,262 @@
+//
+// Compact binary form of the decoded forecast, WxConditions, WxForecast and Daily, for keeping it in RTC memory or
+// flash or sending it over the LAN, at about a twentieth of the size of the JSON it was decoded from.
+//   Header  'W' 'X', version, flags, payload size (uint16), CRC-32 of the payload (uint32), all little-endian
+//   Payload varints: hourly and daily counts, the string table, then the fields of each record in turn
+// Values are fixed point, signed values zigzag encoded, and times are deltas from the first hourly Dt, or from the
+// previous time in the same series, so most take one to three bytes. Each text is an index into the string table,
+// which holds each different text once, so e.g. the hourly icons take a byte each.
+// Reading checks the size and CRC, and then that the whole payload reads, before any record is changed, and needs
+// no heap, other than when a String field of a record has to grow to hold its text.
+// Include after common.h.
+
+#include <Arduino.h>
+#include "esp_rom_crc.h"
+
+#define WIRE_VERSION     2 // 2 added the hourly PoP
+#define WIRE_HEADER_SIZE 10
+#define WIRE_MAX_SIZE    2048 // A forecast is about 600 bytes without texts, and up-to about 1.2k with the daily summaries
+#define WIRE_MAX_STRINGS 64
+#define WIRE_IMPERIAL    0x01 // Flags
+#define WIRE_NO_TEXTS    0x02
+
+class WireWriter {
+  public:
+    WireWriter(uint8_t* buffer, size_t size) : _buffer(buffer), _size(size), _length(0), _overflow(false) {}
+    void Byte(uint8_t value) {
+      if (_length < _size) _buffer[_length++] = value;
+      else _overflow = true;
+    }
+    void Varint(uint32_t value) {
+      while (value >= 0x80) {
+        Byte((value & 0x7F) | 0x80);
+        value >>= 7;
+      }
+      Byte(value);
+    }
+    void Signed(int32_t value) { Varint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31)); }
+    void Quantized(float value, int scale) { Signed(lroundf(value * scale)); }
+    void Text(const char* text) {
+      do Byte(*text); while (*text++);
+    }
+    size_t Length() { return _length; }
+    bool   Overflow() { return _overflow; }
+  private:
+    uint8_t* _buffer;
+    size_t   _size;
+    size_t   _length;
+    bool     _overflow;
+};
+
+class WireReader {
+  public:
+    WireReader(const uint8_t* data, size_t size) : _data(data), _size(size), _position(0), _error(false) {}
+    uint8_t Byte() {
+      if (_position < _size) return _data[_position++];
+      _error = true;
+      return 0;
+    }
+    uint32_t Varint() {
+      uint32_t value = 0;
+      for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = Byte();
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return value;
+      }
+      _error = true; // More than 5 bytes isn't a uint32
+      return 0;
+    }
+    int32_t Signed() {
+      uint32_t value = Varint();
+      return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+    float Quantized(int scale) { return Signed() / (float)scale; }
+    const char* Text() { // Points into the data, so needs no copy
+      const char* text = (const char*)_data + _position;
+      while (Byte() != 0 && !_error) {}
+      return _error ? "" : text;
+    }
+    bool Error() { return _error; }
+  private:
+    const uint8_t* _data;
+    size_t         _size;
+    size_t         _position;
+    bool           _error;
+};
+
+size_t EncodeWire(uint8_t* buffer, size_t size, bool texts);
+bool   DecodeWire(const uint8_t* data, size_t size);
+bool   ReadWire(const uint8_t* data, bool store);
+bool   CheckWire(const uint8_t* data, size_t size);
+int    WireString(const char* strings[], int& count, const char* text);
+
+//#########################################################################################
+// Encodes the records into buffer and returns the bytes used, or 0 if they don't fit. Without texts, the
+// descriptions are left out, as they're the largest part, e.g. for RTC memory, and the icons and trend are kept.
+size_t EncodeWire(uint8_t* buffer, size_t size, bool texts) {
+  if (size < WIRE_HEADER_SIZE) return 0;
+  const char* strings[WIRE_MAX_STRINGS];
+  int count = 0;
+  WireString(strings, count, ""); // Index 0, for a text left out
+  Forecast_record_type& c = WxConditions[0];
+  WireString(strings, count, c.Icon.c_str());
+  WireString(strings, count, c.Trend.c_str());
+  if (texts) WireString(strings, count, c.Description.c_str());
+  for (int r = 0; r < max_readings; r++) WireString(strings, count, WxForecast[r].Icon.c_str());
+  for (int r = 0; r < 8; r++) {
+    WireString(strings, count, Daily[r].Icon.c_str());
+    if (texts) WireString(strings, count, Daily[r].Description.c_str());
+  }
+  if (count >= WIRE_MAX_STRINGS) return 0;
+  WireWriter out(buffer + WIRE_HEADER_SIZE, size - WIRE_HEADER_SIZE);
+  out.Varint(max_readings);
+  out.Varint(8);
+  out.Varint(count);
+  for (int s = 0; s < count; s++) out.Text(strings[s]);
+  uint32_t base = WxForecast[0].Dt; // Times are unsigned, so the differences of any two wrap rather than overflow
+  out.Varint(base);
+  out.Signed(c.Timezone);
+  out.Signed(c.Sunrise - base);
+  out.Signed(c.Sunset - base);
+  out.Quantized(c.Temperature, 100);
+  out.Quantized(c.FeelsLike, 100);
+  out.Quantized(c.Pressure, 100);
+  out.Quantized(c.Humidity, 1);
+  out.Quantized(c.DewPoint, 100);
+  out.Quantized(c.UVI, 100);
+  out.Signed(c.Cloudcover);
+  out.Signed(c.Visibility);
+  out.Quantized(c.Windspeed, 100);
+  out.Quantized(c.Winddir, 1);
+  out.Varint(WireString(strings, count, c.Trend.c_str()));
+  out.Varint(WireString(strings, count, c.Icon.c_str()));
+  out.Varint(texts ? WireString(strings, count, c.Description.c_str()) : 0);
+  uint32_t previous = base;
+  for (int r = 0; r < max_readings; r++) {
+    Forecast_record_type& h = WxForecast[r];
+    out.Signed(h.Dt - previous);
+    previous = h.Dt;
+    out.Quantized(h.Temperature, 100);
+    out.Quantized(h.FeelsLike, 100);
+    out.Quantized(h.Pressure, 100);
+    out.Quantized(h.Humidity, 1);
+    out.Quantized(h.DewPoint, 100);
+    out.Quantized(h.PoP, 100);
+    out.Quantized(h.Rainfall, 100);
+    out.Quantized(h.Snowfall, 100);
+    out.Varint(WireString(strings, count, h.Icon.c_str()));
+  }
+  previous = base;
+  for (int r = 0; r < 8; r++) {
+    Forecast_record_type& d = Daily[r];
+    out.Signed(d.Dt - previous);
+    previous = d.Dt;
+    out.Quantized(d.Temperature, 100);
+    out.Quantized(d.High, 100);
+    out.Quantized(d.Low, 100);
+    out.Quantized(d.Humidity, 1);
+    out.Quantized(d.PoP, 100);
+    out.Quantized(d.UVI, 100);
+    out.Quantized(d.Rainfall, 100);
+    out.Quantized(d.Snowfall, 100);
+    out.Varint(WireString(strings, count, d.Icon.c_str()));
+    out.Varint(texts ? WireString(strings, count, d.Description.c_str()) : 0);
+  }
+  if (out.Overflow() || out.Length() > 0xFFFF) return 0;
+  uint32_t length = out.Length();
+  uint32_t crc    = esp_rom_crc32_le(0, buffer + WIRE_HEADER_SIZE, length);
+  const uint8_t header[WIRE_HEADER_SIZE] = {'W', 'X', WIRE_VERSION, (uint8_t)((Units == "I" ? WIRE_IMPERIAL : 0) | (texts ? 0 : WIRE_NO_TEXTS)),
+                                            (uint8_t)length, (uint8_t)(length >> 8),
+                                            (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+  memcpy(buffer, header, WIRE_HEADER_SIZE);
+  return WIRE_HEADER_SIZE + length;
+}
+//#########################################################################################
+// Decodes into the records, which are only changed if the data is complete, of this version and in the units in use
+bool DecodeWire(const uint8_t* data, size_t size) {
+  if (!CheckWire(data, size)) return false;
+  return ReadWire(data, false) && ReadWire(data, true); // A varint that runs off the end is found before any record changes
+}
+//#########################################################################################
+// Reads the payload of checked data, into the records if store, otherwise only to find whether it all reads
+bool ReadWire(const uint8_t* data, bool store) {
+  WireReader in(data + WIRE_HEADER_SIZE, data[4] | data[5] << 8);
+  int hours = in.Varint();
+  int days  = in.Varint();
+  uint32_t count = in.Varint();
+  if (count > WIRE_MAX_STRINGS) return false;
+  const char* strings[WIRE_MAX_STRINGS];
+  for (uint32_t s = 0; s < count; s++) strings[s] = in.Text();
+  if (in.Error() || count == 0) return false;
+  #define WIRE_TEXT(index) strings[min((uint32_t)(index), count - 1)] // A bad index can't read outside the table
+  Forecast_record_type  unused; // Taken by what isn't stored, the extra hours of a longer forecast or all of a trial read
+  uint32_t base = in.Varint();
+  Forecast_record_type& c = store ? WxConditions[0] : unused;
+  c.Timezone    = in.Signed();
+  c.Sunrise     = base + in.Signed();
+  c.Sunset      = base + in.Signed();
+  c.Temperature = in.Quantized(100);
+  c.FeelsLike   = in.Quantized(100);
+  c.Pressure    = in.Quantized(100);
+  c.Humidity    = in.Quantized(1);
+  c.DewPoint    = in.Quantized(100);
+  c.UVI         = in.Quantized(100);
+  c.Cloudcover  = in.Signed();
+  c.Visibility  = in.Signed();
+  c.Windspeed   = in.Quantized(100);
+  c.Winddir     = in.Quantized(1);
+  c.Trend       = WIRE_TEXT(in.Varint());
+  c.Icon        = WIRE_TEXT(in.Varint());
+  c.Description = WIRE_TEXT(in.Varint());
+  uint32_t previous = base;
+  for (int r = 0; r < hours && !in.Error(); r++) { // Stops at the end of the data, however many hours it claims
+    Forecast_record_type& h = store && r < max_readings ? WxForecast[r] : unused;
+    h.Dt          = previous = previous + in.Signed();
+    h.Temperature = in.Quantized(100);
+    h.FeelsLike   = in.Quantized(100);
+    h.Pressure    = in.Quantized(100);
+    h.Humidity    = in.Quantized(1);
+    h.DewPoint    = in.Quantized(100);
+    h.PoP         = in.Quantized(100);
+    h.Rainfall    = in.Quantized(100);
+    h.Snowfall    = in.Quantized(100);
+    h.Icon        = WIRE_TEXT(in.Varint());
+  }
+  previous = base;
+  for (int r = 0; r < days && !in.Error(); r++) {
+    Forecast_record_type& d = store && r < 8 ? Daily[r] : unused;
+    d.Dt          = previous = previous + in.Signed();
+    d.Temperature = in.Quantized(100);
+    d.High        = in.Quantized(100);
+    d.Low         = in.Quantized(100);
+    d.Humidity    = in.Quantized(1);
+    d.PoP         = in.Quantized(100);
+    d.UVI         = in.Quantized(100);
+    d.Rainfall    = in.Quantized(100);
+    d.Snowfall    = in.Quantized(100);
+    d.Icon        = WIRE_TEXT(in.Varint());
+    d.Description = WIRE_TEXT(in.Varint());
+  }
+  #undef WIRE_TEXT
+  return !in.Error();
+}
+//#########################################################################################
+// True when data holds a complete, undamaged forecast of this version in the units in use
+bool CheckWire(const uint8_t* data, size_t size) {
+  if (size < WIRE_HEADER_SIZE || data[0] != 'W' || data[1] != 'X' || data[2] != WIRE_VERSION) return false;
+  if ((data[3] & ~(WIRE_IMPERIAL | WIRE_NO_TEXTS)) || ((data[3] & WIRE_IMPERIAL) != 0) != (Units == "I")) return false; // Unknown flags too
+  size_t length = data[4] | data[5] << 8;
+  if (WIRE_HEADER_SIZE + length > size) return false;
+  uint32_t crc = data[6] | data[7] << 8 | data[8] << 16 | (uint32_t)data[9] << 24;
+  return crc == esp_rom_crc32_le(0, data + WIRE_HEADER_SIZE, length);
+}
+//#########################################################################################
+// Returns the index of text in the string table, adding it if it's new and there's room
+int WireString(const char* strings[], int& count, const char* text) {
+  for (int s = 0; s < count; s++) {
+    if (strcmp(strings[s], text) == 0) return s;
+  }
+  if (count == WIRE_MAX_STRINGS) return count; // Too many, EncodeWire gives up
+  strings[count] = text;
+  return count++;
+}
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+# Writes the One Call and News API responses in this folder and, for each, the fields a decoder should leave in
+# the records, taken from the response by Python's own JSON parser, so the expectations don't come from the code
+# under test. The One Call responses follow OWM's documented One Call 3.0 schema, with what real responses vary
+# in: ASCII or UTF-8 escapes, compact or indented, hours with and without rain and snow, a polar location with no
+# sunrise or sunset, a shorter forecast, alerts, a summary longer than a decoder keeps, and integers out of the
+# range of the int a decoder keeps them in, which it clamps to the range. The news feeds follow
+# newsapi.org's top-headlines schema, and are the awkward ones: no articles, titles longer than a headline keeps
+# with a multi-byte character across the cut, missing and null fields, and a feed larger than news.h reads.
+#   python3 make_corpus.py            rewrites the responses and expectations
+#   python3 make_corpus.py x.json     prints the expectations of another response, e.g. one captured with curl
+import json, random, sys
+
+MAX_READINGS = 24
+TOKEN_SIZE   = 160 # ONECALL_TOKEN_SIZE, a text is cut to one less, in bytes
+
+def weather(rng):
+  return [{"id": 800, "main": "Clear", "description": rng.choice(["clear sky", "few clouds", "pluie légère", "雨", "zataženo"]),
+           "icon": rng.choice(["01d", "02n", "04d", "10d", "13n"])}]
+
+def response(seed, hours=48, days=8, polar=False, long_summary=False, out_of_range=False):
+  rng  = random.Random(seed)
+  base = 1700000000 + seed * 3600
+  current = {"dt": base, "sunrise": base - 10000, "sunset": base + 30000, "temp": round(rng.uniform(-5, 30), 2), "feels_like": 1.5,
+             "pressure": rng.randint(990, 1030), "humidity": 81, "dew_point": 3.2, "uvi": 0.55, "clouds": 40, "visibility": 10000,
+             "wind_speed": 4.12, "wind_deg": 230, "wind_gust": 7.1, "weather": weather(rng)}
+  if polar:
+    del current["sunrise"], current["sunset"]
+  hourly = []
+  for i in range(hours):
+    hour = {"dt": base + 3600 * i, "temp": round(rng.uniform(-5, 30), 2), "feels_like": round(rng.uniform(-5, 30), 2),
+            "pressure": rng.randint(990, 1030), "humidity": rng.randint(30, 100), "dew_point": 1.1, "uvi": 0.3, "clouds": 20,
+            "visibility": 10000, "wind_speed": 3.3, "wind_deg": 200, "wind_gust": 5.5, "weather": weather(rng), "pop": round(rng.random(), 2)}
+    if rng.random() < 0.4: hour["rain"] = {"1h": round(rng.uniform(0, 5), 2)}
+    if rng.random() < 0.1: hour["snow"] = {"1h": round(rng.uniform(0, 5), 2)}
+    hourly.append(hour)
+  daily = []
+  for i in range(days):
+    summary = "Expect a day of \"partly\" cloudy with rain"
+    if long_summary: summary = "There will be " + "rain and wind, " * 15 + "later clearing"
+    day = {"dt": base + 86400 * i, "sunrise": 1, "sunset": 2, "moonrise": 3, "moonset": 4, "moon_phase": 0.5, "summary": summary,
+           "temp": {"day": 12.3, "min": round(rng.uniform(-10, 10), 2), "max": round(rng.uniform(10, 30), 2), "night": 6, "eve": 9, "morn": 5},
+           "feels_like": {"day": 11, "night": 5, "eve": 8, "morn": 4}, "pressure": 1012, "humidity": rng.randint(30, 100),
+           "dew_point": 5, "wind_speed": 5, "wind_deg": 220, "wind_gust": 9, "weather": weather(rng), "clouds": 75,
+           "pop": round(rng.random(), 2), "rain": 3.5, "uvi": 1.2}
+    if i % 3 == 0: day["snow"] = 0.7
+    daily.append(day)
+  document = {"lat": 51.38, "lon": -2.36, "timezone": "Europe/London", "timezone_offset": 3600, "current": current,
+              "minutely": [{"dt": base + 60 * m, "precipitation": 0} for m in range(61)], "hourly": hourly, "daily": daily}
+  if out_of_range:
+    document["timezone_offset"] = 2 ** 40
+    current["visibility"], current["clouds"], current["sunset"] = 10 ** 30, -10 ** 12, 1e300
+    hourly[0]["dt"], daily[1]["dt"] = -1e300, 4294967296
+  if seed % 2:
+    document["alerts"] = [{"sender_name": "Met Office", "event": "Wind", "start": base, "end": base + 7200,
+                           "description": "Gusts of 60mph\n", "tags": ["Wind"]}]
+  return document
+
+def text(value): # As DecodedText() keeps it, up-to TOKEN_SIZE - 1 bytes
+  if not isinstance(value, str): return ""
+  return value.encode("utf-8")[:TOKEN_SIZE - 1].decode("utf-8", "ignore")
+
+def expectations(document):
+  def get(value, *keys):
+    for key in keys:
+      try: value = value[key]
+      except (KeyError, IndexError, TypeError): return None
+    return value
+  def number(value): return value if isinstance(value, (int, float)) and not isinstance(value, bool) else 0
+  def integer(value): return max(-2 ** 31, min(2 ** 31 - 1, int(number(value)))) # Clamped to an int, as NumberAs() does
+  fields = [("tz", integer(document.get("timezone_offset")))]
+  current = document.get("current", {})
+  fields += [("c.description", text(get(current, "weather", 0, "description"))), ("c.icon", text(get(current, "weather", 0, "icon")))]
+  for key in ["sunrise", "sunset", "temp", "feels_like", "pressure", "humidity", "dew_point", "uvi", "clouds", "visibility", "wind_speed", "wind_deg"]:
+    fields.append(("c." + key, (integer if key in ["sunrise", "sunset", "clouds", "visibility"] else number)(current.get(key))))
+  for r in range(MAX_READINGS):
+    hour = get(document, "hourly", r) or {}
+    for key in ["dt", "temp", "feels_like", "pressure", "humidity", "dew_point", "pop"]:
+      fields.append(("h%d.%s" % (r, key), (integer if key == "dt" else number)(hour.get(key))))
+    fields += [("h%d.rain" % r, number(get(hour, "rain", "1h"))), ("h%d.snow" % r, number(get(hour, "snow", "1h"))),
+               ("h%d.icon" % r, text(get(hour, "weather", 0, "icon")))]
+  for d in range(8):
+    day = get(document, "daily", d) or {}
+    fields += [("d%d.dt" % d, integer(day.get("dt"))), ("d%d.summary" % d, text(day.get("summary"))),
+               ("d%d.temp" % d, number(get(day, "temp", "day"))), ("d%d.high" % d, number(get(day, "temp", "max"))),
+               ("d%d.low" % d, number(get(day, "temp", "min")))]
+    for key in ["humidity", "pop", "uvi", "rain", "snow"]:
+      fields.append(("d%d.%s" % (d, key), number(day.get(key))))
+    fields.append(("d%d.icon" % d, text(get(day, "weather", 0, "icon"))))
+  return "".join("%s=%s\n" % field for field in fields)
+
+NEWS_MAX_HEADLINES = 10
+NEWS_TITLE_SIZE    = 160
+NEWS_SOURCE_SIZE   = 32
+NEWS_MAX_BODY      = 65536
+
+def cut(value, size): # As CopyUtf8() keeps it, up-to size - 1 bytes ending on a whole character
+  if not isinstance(value, str): return ""
+  return value.encode("utf-8")[:size - 1].decode("utf-8", "ignore")
+
+def article(rng, title, source="BBC News", content=200):
+  return {"source": {"id": None, "name": source}, "author": "Staff", "title": title,
+          "description": "A description of the story. " * 3, "url": "https://example.com/%d" % rng.randint(0, 10**9),
+          "urlToImage": None, "publishedAt": "2024-05-01T12:00:00Z", "content": "x" * content + " [+%d chars]" % content}
+
+def feed(articles, ascii=False):
+  # Built from its parts so the offset at which each article ends is known, as a decoder can't read past NEWS_MAX_BODY
+  text, ends = '{"status":"ok","totalResults":%d,"articles":[' % len(articles), []
+  for a, item in enumerate(articles):
+    text += ("," if a else "") + json.dumps(item, ensure_ascii=ascii)
+    ends.append(len(text.encode("utf-8")))
+  return text + "]}", ends
+
+def news_expectations(articles, ends, body):
+  kept = [item for item, end in zip(articles, ends) if end <= NEWS_MAX_BODY][:NEWS_MAX_HEADLINES]
+  fields = [("decoded", 1 if kept or (articles == [] and '"articles"' in body) else 0), ("count", len(kept))]
+  for h, item in enumerate(kept):
+    source = item.get("source")
+    fields += [("title%d" % h, cut(item.get("title"), NEWS_TITLE_SIZE)),
+               ("source%d" % h, cut(source.get("name") if isinstance(source, dict) else None, NEWS_SOURCE_SIZE))]
+  return "".join("%s=%s\n" % field for field in fields)
+
+def news_corpus():
+  rng = random.Random(7)
+  long_title = "Ministers say the plan will cost " + "far more than expected " * 5 # 148 bytes, then a character across the cut
+  yield "news_empty", [], False
+  yield "news_long_titles", [article(rng, long_title + "–" * 12), article(rng, long_title + "日本語のニュース"),
+                              article(rng, long_title + "abcdefghijk" + "😀😀"), article(rng, "Short", source="Le Monde — édition"
+                              " internationale du soir")], False
+  yield "news_missing", [article(rng, None), {"source": None, "title": "No source"}, {"title": "Ünïcödé escaped"}], True
+  yield "news_many", [article(rng, "Story %d" % a) for a in range(40)], False
+  yield "news_oversized", [article(rng, "Big story %d" % a, content=9000) for a in range(8)], False
+
+CORPUS = [ # name, response, ensure_ascii, indent
+  ("onecall_bath",     response(1),                       True,  None),
+  ("onecall_utf8",     response(2),                       False, 2),
+  ("onecall_polar",    response(3, polar=True),           False, None),
+  ("onecall_short",    response(4, hours=12, days=5),     True,  None),
+  ("onecall_summary",  response(5, long_summary=True),    False, 1),
+  ("onecall_range",    response(6, out_of_range=True),    True,  None),
+]
+
+if __name__ == "__main__":
+  if len(sys.argv) > 1:
+    sys.stdout.write(expectations(json.load(open(sys.argv[1], encoding="utf-8"))))
+    sys.exit(0)
+  for name, document, ascii, indent in CORPUS:
+    with open(name + ".json", "w", encoding="utf-8") as out:
+      out.write(json.dumps(document, ensure_ascii=ascii, indent=indent))
+    with open(name + ".expected", "w", encoding="utf-8") as out:
+      out.write(expectations(document))
+  for name, articles, ascii in news_corpus():
+    body, ends = feed(articles, ascii)
+    with open(name + ".json", "w", encoding="utf-8") as out:
+      out.write(body)
+    with open(name + ".expected", "w", encoding="utf-8") as out:
+      out.write(news_expectations(articles, ends, body))
@@ -0,0 +1,91 @@
+//
+// Stands in for libFuzzer where the compiler has none (e.g. g++), so the fuzz targets still build and run. Takes
+// the same arguments as a libFuzzer binary: -runs=N, -seed=N and -max_len=N, then seed folders or files. Each seed
+// is run as it is, then N inputs made by mutating random seeds, with the same seed always giving the same inputs.
+// Unlike libFuzzer it has no coverage feedback, so it finds less in the same time, and nothing is written back.
+// The library's own logging is sent to /dev/null, findings are reported on stderr by the sanitizers.
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+//#########################################################################################
+void AddSeeds(std::vector<std::string>& seeds, const std::string& path) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    fprintf(stderr, "Can't read %s\n", path.c_str());
+    exit(2);
+  }
+  if (S_ISDIR(info.st_mode)) {
+    DIR* folder = opendir(path.c_str());
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(folder)) {
+      if (entry->d_name[0] != '.') names.push_back(path + "/" + entry->d_name);
+    }
+    closedir(folder);
+    std::sort(names.begin(), names.end());
+    for (auto& name : names) AddSeeds(seeds, name);
+    return;
+  }
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream content;
+  content << file.rdbuf();
+  seeds.push_back(content.str());
+}
+//#########################################################################################
+// A few random edits of input, of the kinds that break parsers: bytes dropped, changed or repeated, tokens spliced
+// in, and runs of brackets for deep nesting
+std::string Mutate(std::string input, const std::vector<std::string>& seeds, std::mt19937& random, size_t maxLength) {
+  static const char* tokens[] = {"{", "}", "[", "]", ",", ":", "\"", "\\", "\\u", "\\ud800", "\\u0000", "-", "1e999", "-0.", "null",
+                                 "true", "tru", "\xff", "\xc3", "\xe2\x80", "\x80", "\0", "4294967295", "\"hourly\":[", "\"daily\":[", "\"articles\":["};
+  int edits = 1 + random() % 8;
+  for (int e = 0; e < edits; e++) {
+    size_t at = input.empty() ? 0 : random() % input.size();
+    switch (random() % 7) {
+      case 0: input.erase(at, 1 + random() % 64); break;
+      case 1: input.insert(at, tokens[random() % (sizeof(tokens) / sizeof(tokens[0]))]); break;
+      case 2: if (!input.empty()) input[at] = random(); break;
+      case 3: if (!input.empty()) input[at] ^= 1 << (random() % 8); break;
+      case 4: input.insert(at, std::string(1 + random() % 3000, "[{"[random() % 2])); break;
+      case 5: input.insert(at, input.substr(random() % (input.size() + 1), 1 + random() % 256)); break;
+      case 6: { // Splice in part of another seed
+        const std::string& other = seeds[random() % seeds.size()];
+        input.insert(at, other.substr(random() % (other.size() + 1), 1 + random() % 512));
+        break;
+      }
+    }
+  }
+  if (input.size() > maxLength) input.resize(maxLength);
+  return input;
+}
+//#########################################################################################
+int main(int argc, char* argv[]) {
+  long runs = 10000, seed = 1, maxLength = 200000;
+  std::vector<std::string> seeds;
+  for (int a = 1; a < argc; a++) {
+    if (sscanf(argv[a], "-runs=%ld", &runs) == 1 || sscanf(argv[a], "-seed=%ld", &seed) == 1 || sscanf(argv[a], "-max_len=%ld", &maxLength) == 1) continue;
+    if (argv[a][0] == '-') fprintf(stderr, "Ignoring %s\n", argv[a]);
+    else AddSeeds(seeds, argv[a]);
+  }
+  if (seeds.empty()) seeds.push_back("");
+  if (freopen("/dev/null", "w", stdout) == NULL) return 2;
+  for (auto& input : seeds) LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+  std::mt19937 random(seed);
+  for (long run = 0; run < runs; run++) {
+    std::string input = Mutate(seeds[random() % seeds.size()], seeds, random, maxLength);
+    LLVMFuzzerTestOneInput((const uint8_t*)input.data(), input.size());
+  }
+  fprintf(stderr, "%s: %zu seeds and %ld mutated inputs, no findings\n", argv[0], seeds.size(), runs);
+  return 0;
+}
@@ -0,0 +1,25 @@
+//
+// Fuzz target for the News decoder: any response must be decoded or rejected without a crash, a read out of
+// bounds, undefined behaviour or unbounded time, and every headline kept must fit its buffer. Needs ArduinoJson.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "news.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  MemoryStream body(std::string((const char*)data, size), 61);
+  DecodeNewsHeadlines(body, false);
+  if (HeadlineCount < 0 || HeadlineCount > NEWS_MAX_HEADLINES) abort();
+  for (int h = 0; h < HeadlineCount; h++) {
+    if (strnlen(Headlines[h].Title, NEWS_TITLE_SIZE) == NEWS_TITLE_SIZE || strnlen(Headlines[h].Source, NEWS_SOURCE_SIZE) == NEWS_SOURCE_SIZE) abort();
+  }
+  return 0;
+}
@@ -0,0 +1,29 @@
+//
+// Fuzz target for the One Call decoders: any response must be decoded or rejected without a crash, a read out of
+// bounds, undefined behaviour or unbounded time. Both decoders are run when built with ArduinoJson.
+
+#include <Arduino.h>
+#ifdef HAVE_ARDUINOJSON
+#include <ArduinoJson.h>
+#else
+#define ONECALL_STREAM_PARSER
+#endif
+#include <WiFi.h>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  std::string body((const char*)data, size);
+  MemoryStream streamed(body, 61);
+  DecodeOneCallStreamed(streamed, false);
+#ifdef HAVE_ARDUINOJSON
+  MemoryStream json(body, 61);
+  DecodeOneCallWeather(json, false);
+#endif
+  return 0;
+}
@@ -0,0 +1,32 @@
+//
+// Fuzz target for DecodeWire(). Each input is decoded as it is, which mostly exercises the header and CRC checks,
+// and again with its header's size and CRC made to match, so that mutations reach the payload decoder. Whatever
+// decodes must encode again.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "wire_format.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  DecodeWire(data, size);
+  if (size < WIRE_HEADER_SIZE || size - WIRE_HEADER_SIZE > 0xFFFF) return 0;
+  std::vector<uint8_t> fixed(data, data + size);
+  size_t   length = size - WIRE_HEADER_SIZE;
+  uint32_t crc    = esp_rom_crc32_le(0, fixed.data() + WIRE_HEADER_SIZE, length);
+  const uint8_t header[] = {'W', 'X', WIRE_VERSION, (uint8_t)(fixed[3] & WIRE_NO_TEXTS), (uint8_t)length, (uint8_t)(length >> 8),
+                            (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24)};
+  memcpy(fixed.data(), header, WIRE_HEADER_SIZE);
+  if (DecodeWire(fixed.data(), fixed.size())) {
+    uint8_t again[WIRE_MAX_SIZE * 4];
+    EncodeWire(again, sizeof(again), true);
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+//
+// Writes the seed inputs for fuzz_wire: each One Call response in corpus/ decoded and then encoded with and
+// without its texts, into the folder given.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "wire_format.h"
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: wire_seeds <folder>\n");
+    return 2;
+  }
+  for (auto& name : CorpusFiles("onecall_")) {
+    MemoryStream json(ReadFile(CORPUS + name + ".json"));
+    if (!DecodeOneCallStreamed(json, false)) continue;
+    for (bool texts : {true, false}) {
+      uint8_t buffer[WIRE_MAX_SIZE];
+      size_t  size = EncodeWire(buffer, sizeof(buffer), texts);
+      std::string path = std::string(argv[1]) + "/" + name + (texts ? ".wire" : "_no_texts.wire");
+      FILE* file = fopen(path.c_str(), "wb");
+      if (file == NULL || fwrite(buffer, 1, size, file) != size) {
+        fprintf(stderr, "Can't write %s\n", path.c_str());
+        return 1;
+      }
+      fclose(file);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,274 @@
+//
+// Just enough of the ESP32 Arduino core to build the library's hardware-independent modules on a PC, for the host
+// tests in test/. String, Print and Stream behave as the core's do for what the library uses. millis() is a fake
+// clock that only delay() and the tests move, so a test of timing gives the same result on every run.
+
+#pragma once
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <string>
+#include <algorithm>
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#define PI              3.1415926535897932384626433832795
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define F(text)         text
+#define PSTR(text)      text
+#define PGM_P           const char*
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_IRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+using std::min;
+using std::max;
+using std::isnan;
+
+template <class T> T constrain(T value, T low, T high) { return value < low ? low : (value > high ? high : value); }
+
+extern unsigned long ShimMillis; // The fake clock, moved by delay() and the tests
+extern uint32_t      ShimMHz;    // Set by setCpuFrequencyMhz()
+extern uint32_t      ShimMilliVolts;
+
+unsigned long millis();
+unsigned long micros();
+void          delay(unsigned long ms);
+void          yield();
+uint32_t      esp_random();
+void          ShimRandomSeed(uint32_t seed);
+inline int      analogRead(int) { return ShimMilliVolts * 4095 / 3300; }
+inline uint32_t analogReadMilliVolts(int) { return ShimMilliVolts; }
+inline void     pinMode(int, int) {}
+inline void     digitalWrite(int, int) {}
+inline int      digitalRead(int) { return HIGH; }
+inline long     random(long high) { return high > 0 ? esp_random() % high : 0; }
+inline long     random(long low, long high) { return high > low ? low + (long)(esp_random() % (high - low)) : low; }
+inline uint32_t getCpuFrequencyMhz() { return ShimMHz; }
+inline bool     setCpuFrequencyMhz(uint32_t mhz) { ShimMHz = mhz; return true; }
+
+inline size_t shim_strlcpy(char* destination, const char* source, size_t size) {
+  size_t length = strlen(source);
+  if (size > 0) {
+    size_t copied = length < size - 1 ? length : size - 1;
+    memcpy(destination, source, copied);
+    destination[copied] = 0;
+  }
+  return length;
+}
+#define strlcpy shim_strlcpy
+
+class String {
+  public:
+    String() {}
+    String(const char* text) : _s(text ? text : "") {}
+    String(const std::string& text) : _s(text) {}
+    String(char c) : _s(1, c) {}
+    String(int value) : _s(std::to_string(value)) {}
+    String(unsigned value) : _s(std::to_string(value)) {}
+    String(long value) : _s(std::to_string(value)) {}
+    String(unsigned long value) : _s(std::to_string(value)) {}
+    String(long long value) : _s(std::to_string(value)) {}
+    String(unsigned long long value) : _s(std::to_string(value)) {}
+    String(double value, int decimals = 2) {
+      char text[48];
+      snprintf(text, sizeof(text), "%.*f", decimals, value);
+      _s = text;
+    }
+    const char* c_str() const { return _s.c_str(); }
+    unsigned    length() const { return _s.size(); }
+    bool        isEmpty() const { return _s.empty(); }
+    void        reserve(unsigned size) { _s.reserve(size); }
+    char        operator[](unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+    char&       operator[](unsigned i) { return _s[i]; }
+    char        charAt(unsigned i) const { return (*this)[i]; }
+    String&     operator+=(const String& other) { _s += other._s; return *this; }
+    String&     operator+=(const char* other) { _s += other; return *this; }
+    String&     operator+=(char c) { _s += c; return *this; }
+    bool        concat(char c) { _s += c; return true; }
+    bool        concat(const String& other) { _s += other._s; return true; }
+    bool        operator==(const String& other) const { return _s == other._s; }
+    bool        operator==(const char* other) const { return _s == other; }
+    bool        operator!=(const String& other) const { return _s != other._s; }
+    bool        operator!=(const char* other) const { return _s != other; }
+    bool        operator<(const String& other) const { return _s < other._s; }
+    int         compareTo(const String& other) const { return _s.compare(other._s); }
+    bool        equals(const String& other) const { return _s == other._s; }
+    bool        equalsIgnoreCase(const String& other) const { return strcasecmp(c_str(), other.c_str()) == 0; }
+    bool        startsWith(const String& prefix) const { return _s.rfind(prefix._s, 0) == 0; }
+    bool        endsWith(const String& suffix) const { return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0; }
+    int         indexOf(char c, unsigned from = 0) const { return Found(_s.find(c, from)); }
+    int         indexOf(const String& text, unsigned from = 0) const { return Found(_s.find(text._s, from)); }
+    int         lastIndexOf(char c) const { return Found(_s.rfind(c)); }
+    String      substring(unsigned from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String      substring(unsigned from, unsigned to) const { return from < _s.size() && to > from ? String(_s.substr(from, to - from)) : String(); }
+    void        remove(unsigned from) { if (from < _s.size()) _s.erase(from); }
+    void        remove(unsigned from, unsigned count) { if (from < _s.size()) _s.erase(from, count); }
+    void        replace(const String& find, const String& with) {
+      if (find._s.empty()) return;
+      for (size_t at = _s.find(find._s); at != std::string::npos; at = _s.find(find._s, at + with._s.size())) _s.replace(at, find._s.size(), with._s);
+    }
+    void        trim() {
+      size_t first = _s.find_first_not_of(" \t\r\n");
+      size_t last  = _s.find_last_not_of(" \t\r\n");
+      _s = first == std::string::npos ? std::string() : _s.substr(first, last - first + 1);
+    }
+    void        toUpperCase() { for (char& c : _s) c = toupper((unsigned char)c); }
+    void        toLowerCase() { for (char& c : _s) c = tolower((unsigned char)c); }
+    long        toInt() const { return atol(c_str()); }
+    float       toFloat() const { return atof(c_str()); }
+    double      toDouble() const { return atof(c_str()); }
+    friend String operator+(const String& a, const String& b) { return String(a._s + b._s); }
+    friend String operator+(const String& a, const char* b) { return String(a._s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b._s); }
+    friend String operator+(const String& a, char b) { return String(a._s + b); }
+  private:
+    static int Found(size_t at) { return at == std::string::npos ? -1 : (int)at; }
+    std::string _s;
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t size) {
+      for (size_t i = 0; i < size; i++) write(data[i]);
+      return size;
+    }
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    virtual void flush() {}
+    size_t print(const String& text) { return write((const uint8_t*)text.c_str(), text.length()); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int value) { return print(String(value)); }
+    size_t print(unsigned value) { return print(String(value)); }
+    size_t print(long value) { return print(String(value)); }
+    size_t print(unsigned long value) { return print(String(value)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, decimals)); }
+    template <class T> size_t println(T value) { return print(value) + println(); }
+    size_t println(double value, int decimals) { return print(value, decimals) + println(); }
+    size_t println() { return write("\r\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+      va_list args;
+      va_start(args, format);
+      int length = vsnprintf(NULL, 0, format, args);
+      va_end(args);
+      std::string text(length > 0 ? length : 0, 0);
+      va_start(args, format);
+      vsnprintf(&text[0], text.size() + 1, format, args);
+      va_end(args);
+      return write((const uint8_t*)text.data(), text.size());
+    }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void          setTimeout(unsigned long ms) { _timeout = ms; }
+    unsigned long getTimeout() { return _timeout; }
+    virtual size_t readBytes(char* buffer, size_t size) {
+      size_t count = 0;
+      for (int c; count < size && (c = read()) >= 0; count++) buffer[count] = c;
+      return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t size) { return readBytes((char*)buffer, size); }
+    bool find(const char* target) { return findUntil(target, NULL); }
+    bool findUntil(const char* target, const char* terminator) { // Restarts a partial match, as the core's does
+      size_t length = strlen(target), matched = 0, ended = 0;
+      size_t terminatorLength = terminator ? strlen(terminator) : 0;
+      for (int c; (c = read()) >= 0;) {
+        if (c == target[matched]) { if (++matched == length) return true; }
+        else matched = c == target[0];
+        if (terminatorLength > 0) {
+          if (c == terminator[ended]) { if (++ended == terminatorLength) return false; }
+          else ended = c == terminator[0];
+        }
+      }
+      return false;
+    }
+    String readStringUntil(char terminator) {
+      String text;
+      for (int c; (c = read()) >= 0 && c != terminator;) text += (char)c;
+      return text;
+    }
+  protected:
+    unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream { // Writes to stdout, reads nothing
+  public:
+    bool   Quiet = false; // Drops the output, e.g. the messages of many inputs a test expects to be rejected
+    void   begin(unsigned long) {}
+    size_t write(uint8_t c) override { return Quiet ? 1 : fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* data, size_t size) override { return Quiet ? size : fwrite(data, 1, size, stdout); }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+class IPAddress {
+  public:
+    IPAddress() { memset(_bytes, 0, 4); }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { _bytes[0] = a; _bytes[1] = b; _bytes[2] = c; _bytes[3] = d; }
+    IPAddress(uint32_t address) { memcpy(_bytes, &address, 4); }
+    operator uint32_t() const { uint32_t address; memcpy(&address, _bytes, 4); return address; }
+    uint8_t  operator[](int i) const { return _bytes[i]; }
+    uint8_t& operator[](int i) { return _bytes[i]; }
+    bool     fromString(const char* text) {
+      unsigned a, b, c, d;
+      if (sscanf(text, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) return false;
+      *this = IPAddress(a, b, c, d);
+      return true;
+    }
+    String toString() const { return String(_bytes[0]) + "." + String(_bytes[1]) + "." + String(_bytes[2]) + "." + String(_bytes[3]); }
+  private:
+    uint8_t _bytes[4];
+};
+
+class Client : public Stream {
+  public:
+    virtual int     connect(IPAddress ip, uint16_t port) = 0;
+    virtual int     connect(const char* host, uint16_t port) = 0;
+    virtual size_t  write(uint8_t c) = 0;
+    virtual size_t  write(const uint8_t* data, size_t size) = 0;
+    virtual int     read(uint8_t* buffer, size_t size) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void    stop() = 0;
+    virtual operator bool() = 0;
+    using Stream::read;
+};
+
+#include "freertos_shim.h"
+
+struct EspClass {
+  uint32_t getFreeHeap() { return 0; }
+  uint32_t getMinFreeHeap() { return 0; }
+  uint32_t getMaxAllocHeap() { return 0; }
+  uint64_t getEfuseMac() { return ShimEfuseMac; }
+  void     restart() {}
+  static uint64_t ShimEfuseMac;
+};
+extern EspClass ESP;
+
+enum { ESP_RST_UNKNOWN = 0, ESP_RST_POWERON = 1, ESP_RST_SW = 3, ESP_RST_DEEPSLEEP = 8 };
+inline int   esp_reset_reason() { return ESP_RST_POWERON; }
+inline void  esp_restart() {}
+inline bool  psramFound() { return false; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+inline void* ps_realloc(void* p, size_t size) { return realloc(p, size); }
@@ -0,0 +1,37 @@
+//
+// HTTPClient for the host tests, every request fails to connect, so a module builds without a network.
+
+#pragma once
+#include "WiFi.h"
+
+#define HTTP_CODE_OK                200
+#define HTTP_CODE_NOT_MODIFIED      304
+#define HTTP_CODE_NOT_FOUND         404
+#define HTTP_CODE_TOO_MANY_REQUESTS 429
+#define HTTPC_ERROR_CONNECTION_REFUSED -1
+#define HTTPC_ERROR_READ_TIMEOUT       -11
+
+class HTTPClient {
+  public:
+    bool        begin(WiFiClient&, String, uint16_t, String = "/", bool = false) { return true; }
+    bool        begin(WiFiClient&, String) { return true; }
+    void        end() {}
+    void        setReuse(bool) {}
+    void        useHTTP10(bool = true) {}
+    void        setTimeout(uint16_t) {}
+    void        setConnectTimeout(int32_t) {}
+    void        setUserAgent(const String&) {}
+    void        addHeader(const String&, const String&, bool = false, bool = true) {}
+    void        collectHeaders(const char*[], size_t) {}
+    String      header(const char*) { return String(); }
+    bool        hasHeader(const char*) { return false; }
+    int         GET() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+    int         getSize() { return -1; }
+    String      getString() { return String(); }
+    WiFiClient& getStream() { return _client; }
+    WiFiClient* getStreamPtr() { return &_client; }
+    bool        connected() { return false; }
+    static String errorToString(int error) { return "error " + String(error); }
+  private:
+    WiFiClient _client;
+};
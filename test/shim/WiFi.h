@@ -0,0 +1,66 @@
+//
+// WiFi for the host tests, never connected, a WiFiClient that connects nowhere, and the status a test sets.
+
+#pragma once
+#include "Arduino.h"
+
+#define WL_IDLE_STATUS     0
+#define WL_NO_SSID_AVAIL   1
+#define WL_CONNECTED       3
+#define WL_CONNECT_FAILED  4
+#define WL_CONNECTION_LOST 5
+#define WL_DISCONNECTED    6
+#define WIFI_OFF           0
+#define WIFI_STA           1
+#define WIFI_AP            2
+#define WIFI_POWER_19_5dBm 78
+
+class WiFiClass {
+  public:
+    int            status() { return Status; }
+    int            begin(const char*, const char*, int32_t = 0, const uint8_t* = NULL, bool = true) { return Status; }
+    bool           disconnect(bool = false, bool = false) { return true; }
+    bool           mode(int m) { Mode = m; return true; }
+    int            getMode() { return Mode; }
+    bool           setSleep(bool) { return true; }
+    bool           setAutoReconnect(bool) { return true; }
+    bool           setTxPower(int) { return true; }
+    bool           config(IPAddress, IPAddress, IPAddress, IPAddress = IPAddress(), IPAddress = IPAddress()) { return true; }
+    int8_t         RSSI() { return -60; }
+    int32_t        channel() { return Channel; }
+    const uint8_t* BSSID() { return Bssid; }
+    IPAddress      localIP() { return IPAddress(192, 168, 1, 50); }
+    IPAddress      gatewayIP() { return IPAddress(192, 168, 1, 1); }
+    IPAddress      subnetMask() { return IPAddress(255, 255, 255, 0); }
+    IPAddress      dnsIP(int = 0) { return IPAddress(192, 168, 1, 1); }
+    String         macAddress() { return "24:0A:C4:00:00:01"; }
+    uint8_t*       macAddress(uint8_t* mac) { memcpy(mac, Mac, 6); return mac; }
+    int            hostByName(const char*, IPAddress& ip) { ip = IPAddress(); return 0; }
+    int            Status  = WL_DISCONNECTED;
+    int            Mode    = WIFI_OFF;
+    int32_t        Channel = 1;
+    uint8_t        Bssid[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+    uint8_t        Mac[6]   = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+};
+extern WiFiClass WiFi;
+
+class WiFiClient : public Client {
+  public:
+    int      connect(IPAddress, uint16_t) override { return 0; }
+    int      connect(const char*, uint16_t) override { return 0; }
+    int      connect(IPAddress ip, uint16_t port, int32_t) { return connect(ip, port); }
+    int      connect(const char* host, uint16_t port, int32_t) { return connect(host, port); }
+    size_t   write(uint8_t) override { return 0; }
+    size_t   write(const uint8_t*, size_t) override { return 0; }
+    using Print::write;
+    int      available() override { return 0; }
+    int      read() override { return -1; }
+    int      read(uint8_t*, size_t) override { return -1; }
+    int      peek() override { return -1; }
+    uint8_t  connected() override { return 0; }
+    void     stop() override {}
+    void     setNoDelay(bool) {}
+    int      fd() const { return -1; }
+    IPAddress remoteIP() { return IPAddress(); }
+    operator bool() override { return false; }
+};
@@ -0,0 +1,9 @@
+#pragma once
+#include "esp_now.h"
+
+typedef int gpio_num_t;
+typedef enum { GPIO_INTR_DISABLE = 0, GPIO_INTR_LOW_LEVEL = 4, GPIO_INTR_HIGH_LEVEL = 5 } gpio_int_type_t;
+
+extern int ShimWakeLevel; // The level a light sleep wakes on, 0 if none
+inline esp_err_t gpio_wakeup_enable(gpio_num_t, gpio_int_type_t level) { ShimWakeLevel = level; return ESP_OK; }
+inline esp_err_t gpio_wakeup_disable(gpio_num_t) { ShimWakeLevel = 0; return ESP_OK; }
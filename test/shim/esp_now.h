@@ -0,0 +1,40 @@
+//
+// ESP-NOW and the ESP-IDF basics for the host tests. Sent frames are kept, for a test to pass to a receiver.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef ESP_IDF_VERSION_MAJOR
+#define ESP_IDF_VERSION_MAJOR 5
+#endif
+#define ESP_OK           0
+#define ESP_FAIL         -1
+#define ESP_NOW_ETH_ALEN 6
+#define WIFI_IF_STA      0
+
+typedef int esp_err_t;
+typedef struct {
+  uint8_t* src_addr;
+  uint8_t* des_addr;
+} esp_now_recv_info_t;
+typedef struct {
+  uint8_t peer_addr[ESP_NOW_ETH_ALEN];
+  uint8_t channel;
+  int     ifidx;
+  bool    encrypt;
+} esp_now_peer_info_t;
+typedef void (*esp_now_recv_cb_t)(const esp_now_recv_info_t* info, const uint8_t* data, int length);
+
+extern std::vector<std::vector<uint8_t>> ShimSentFrames;
+
+inline esp_err_t esp_now_init() { return ESP_OK; }
+inline esp_err_t esp_now_deinit() { return ESP_OK; }
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) { return ESP_OK; }
+inline esp_err_t esp_now_unregister_recv_cb() { return ESP_OK; }
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t*) { return ESP_OK; }
+inline esp_err_t esp_now_send(const uint8_t*, const uint8_t* data, size_t length) {
+  ShimSentFrames.emplace_back(data, data + length);
+  return ESP_OK;
+}
@@ -0,0 +1,8 @@
+//
+// The ROM CRC-32, as zlib's, which is the same little-endian CRC.
+
+#pragma once
+#include <cstdint>
+#include <zlib.h>
+
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* data, uint32_t length) { return crc32(crc, data, length); }
@@ -0,0 +1,26 @@
+//
+// Sleep for the host tests, a light sleep moves the fake clock on by ShimLightSleep ms, deep sleep does nothing.
+
+#pragma once
+#include <cstdint>
+#include "esp_now.h"
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0, ESP_SLEEP_WAKEUP_ALL = 0, ESP_SLEEP_WAKEUP_EXT0 = 2, ESP_SLEEP_WAKEUP_EXT1 = 3,
+  ESP_SLEEP_WAKEUP_TIMER = 4, ESP_SLEEP_WAKEUP_TOUCHPAD = 5, ESP_SLEEP_WAKEUP_ULP = 6, ESP_SLEEP_WAKEUP_GPIO = 7
+} esp_sleep_source_t;
+typedef esp_sleep_source_t esp_sleep_wakeup_cause_t;
+
+extern int           ShimWakeSources;
+extern int           ShimLightSleeps;
+extern unsigned long ShimLightSleep;
+extern esp_sleep_wakeup_cause_t ShimWakeCause;
+
+esp_err_t esp_light_sleep_start();
+inline esp_err_t esp_sleep_enable_timer_wakeup(uint64_t) { ShimWakeSources |= 1 << ESP_SLEEP_WAKEUP_TIMER; return ESP_OK; }
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { ShimWakeSources |= 1 << ESP_SLEEP_WAKEUP_GPIO; return ESP_OK; }
+inline esp_err_t esp_sleep_enable_ext0_wakeup(int, int) { ShimWakeSources |= 1 << ESP_SLEEP_WAKEUP_EXT0; return ESP_OK; }
+inline esp_err_t esp_sleep_enable_ext1_wakeup(uint64_t, int) { ShimWakeSources |= 1 << ESP_SLEEP_WAKEUP_EXT1; return ESP_OK; }
+inline esp_err_t esp_sleep_disable_wakeup_source(esp_sleep_source_t source) { ShimWakeSources &= ~(1 << source); return ESP_OK; }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return ShimWakeCause; }
+inline void esp_deep_sleep_start() {}
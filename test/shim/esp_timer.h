@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+
+extern int64_t ShimMicros; // us since boot, advanced with the fake millis() clock
+inline int64_t esp_timer_get_time() { return ShimMicros; }
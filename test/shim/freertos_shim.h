@@ -0,0 +1,70 @@
+//
+// FreeRTOS as seen by a single-threaded host test, a task runs to completion when it's created, semaphores and
+// mutexes never block, and a queue is a ring buffer, so an item is received only after it has been sent.
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+typedef void*    SemaphoreHandle_t;
+typedef void*    TaskHandle_t;
+typedef int      BaseType_t;
+typedef uint32_t TickType_t;
+typedef int      portMUX_TYPE;
+
+#define pdPASS                      1
+#define pdFAIL                      0
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define portMAX_DELAY               0xFFFFFFFF
+#define pdMS_TO_TICKS(ms)           (ms)
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)     (void)(mux)
+#define portEXIT_CRITICAL(mux)      (void)(mux)
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return (SemaphoreHandle_t)1; }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return (SemaphoreHandle_t)1; }
+inline SemaphoreHandle_t xSemaphoreCreateCounting(int, int) { return (SemaphoreHandle_t)1; }
+inline BaseType_t        xSemaphoreTake(SemaphoreHandle_t, TickType_t) { return pdTRUE; }
+inline BaseType_t        xSemaphoreGive(SemaphoreHandle_t) { return pdTRUE; }
+inline void              vSemaphoreDelete(SemaphoreHandle_t) {}
+
+inline BaseType_t xTaskCreate(void (*task)(void*), const char*, uint32_t, void* parameter, int, TaskHandle_t* handle) {
+  if (handle) *handle = NULL;
+  task(parameter);
+  return pdPASS;
+}
+inline BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char* name, uint32_t stack, void* parameter, int priority, TaskHandle_t* handle, int) {
+  return xTaskCreate(task, name, stack, parameter, priority, handle);
+}
+inline void vTaskDelete(TaskHandle_t) {}
+inline void vTaskDelay(TickType_t) {}
+
+struct ShimQueue {
+  int      Length, Size, Head, Count;
+  uint8_t* Items;
+};
+typedef ShimQueue* QueueHandle_t;
+
+inline QueueHandle_t xQueueCreate(int length, int size) {
+  ShimQueue* queue = new ShimQueue{length, size, 0, 0, (uint8_t*)malloc((size_t)length * size)};
+  return queue;
+}
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t) {
+  if (queue->Count == queue->Length) return pdFALSE;
+  memcpy(queue->Items + ((queue->Head + queue->Count) % queue->Length) * queue->Size, item, queue->Size);
+  queue->Count++;
+  return pdTRUE;
+}
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t) {
+  if (queue->Count == 0) return pdFALSE;
+  memcpy(item, queue->Items + queue->Head * queue->Size, queue->Size);
+  queue->Head = (queue->Head + 1) % queue->Length;
+  queue->Count--;
+  return pdTRUE;
+}
+inline void vQueueDelete(QueueHandle_t queue) {
+  free(queue->Items);
+  delete queue;
+}
@@ -0,0 +1,24 @@
+//
+// lwIP's BSD sockets are the host's.
+
+#pragma once
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define lwip_socket     socket
+#define lwip_connect    ::connect
+#define lwip_select     select
+#define lwip_getsockopt getsockopt
+#define lwip_setsockopt setsockopt
+#define lwip_close      close
+#define lwip_send       send
+#define lwip_recv       recv
+#define lwip_sendto     sendto
+#define lwip_recvfrom   recvfrom
+#define lwip_bind       bind
@@ -0,0 +1,13 @@
+//
+// Message digests for the host tests, SHA-256 and its HMAC only, implemented in shim.cpp.
+
+#pragma once
+#include <cstddef>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+typedef struct mbedtls_md_info_t mbedtls_md_info_t;
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type);
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output);
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keyLength, const unsigned char* input, size_t length,
+                    unsigned char* output);
@@ -0,0 +1,64 @@
+//
+// TLS for the host tests, enough for tls_client.h to build, a handshake fails as no server is reached.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "version.h"
+
+#define MBEDTLS_ERR_SSL_WANT_READ                    -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE                   -0x6880
+#define MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET  -0x7B00
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL             -0x6A00
+#define MBEDTLS_SSL_IS_CLIENT                0
+#define MBEDTLS_SSL_TRANSPORT_STREAM         0
+#define MBEDTLS_SSL_PRESET_DEFAULT           0
+#define MBEDTLS_SSL_VERIFY_NONE              0
+#define MBEDTLS_SSL_VERIFY_REQUIRED          2
+#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED  1
+
+enum { MBEDTLS_SSL_HELLO_REQUEST, MBEDTLS_SSL_CLIENT_HELLO, MBEDTLS_SSL_SERVER_HELLO, MBEDTLS_SSL_SERVER_CERTIFICATE,
+       MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC = 11, MBEDTLS_SSL_HANDSHAKE_OVER = 16 }; // The 2.x states tls_client.h looks at
+
+typedef struct { int unused; } mbedtls_ssl_session;
+typedef struct {
+  int state;
+} mbedtls_ssl_context;
+typedef struct { int unused; } mbedtls_ssl_config;
+typedef struct {
+  unsigned char* p;
+  size_t         len;
+} mbedtls_x509_buf;
+typedef struct {
+  mbedtls_x509_buf raw;
+} mbedtls_x509_crt;
+typedef int mbedtls_ssl_send_t(void*, const unsigned char*, size_t);
+typedef int mbedtls_ssl_recv_t(void*, unsigned char*, size_t);
+typedef int mbedtls_ssl_recv_timeout_t(void*, unsigned char*, size_t, uint32_t);
+
+inline void   mbedtls_ssl_init(mbedtls_ssl_context* ssl) { ssl->state = MBEDTLS_SSL_HELLO_REQUEST; }
+inline void   mbedtls_ssl_free(mbedtls_ssl_context*) {}
+inline void   mbedtls_ssl_config_init(mbedtls_ssl_config*) {}
+inline void   mbedtls_ssl_config_free(mbedtls_ssl_config*) {}
+inline int    mbedtls_ssl_config_defaults(mbedtls_ssl_config*, int, int, int) { return 0; }
+inline void   mbedtls_ssl_conf_authmode(mbedtls_ssl_config*, int) {}
+inline void   mbedtls_ssl_conf_rng(mbedtls_ssl_config*, int (*)(void*, unsigned char*, size_t), void*) {}
+inline void   mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config*, int) {}
+inline int    mbedtls_ssl_setup(mbedtls_ssl_context*, const mbedtls_ssl_config*) { return 0; }
+inline int    mbedtls_ssl_set_hostname(mbedtls_ssl_context*, const char*) { return 0; }
+inline void   mbedtls_ssl_set_bio(mbedtls_ssl_context*, void*, mbedtls_ssl_send_t*, mbedtls_ssl_recv_t*, mbedtls_ssl_recv_timeout_t*) {}
+inline int    mbedtls_ssl_handshake(mbedtls_ssl_context*) { return -0x7780; } // Fatal alert received
+inline int    mbedtls_ssl_handshake_step(mbedtls_ssl_context*) { return -0x7780; }
+inline int    mbedtls_ssl_read(mbedtls_ssl_context*, unsigned char*, size_t) { return 0; }
+inline int    mbedtls_ssl_write(mbedtls_ssl_context*, const unsigned char*, size_t length) { return (int)length; }
+inline size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context*) { return 0; }
+inline int    mbedtls_ssl_close_notify(mbedtls_ssl_context*) { return 0; }
+inline int    mbedtls_ssl_session_reused(const mbedtls_ssl_context*) { return 0; }
+inline const mbedtls_x509_crt* mbedtls_ssl_get_peer_cert(const mbedtls_ssl_context*) { return NULL; }
+inline void   mbedtls_ssl_session_init(mbedtls_ssl_session*) {}
+inline void   mbedtls_ssl_session_free(mbedtls_ssl_session*) {}
+inline int    mbedtls_ssl_session_load(mbedtls_ssl_session*, const unsigned char*, size_t) { return -1; }
+inline int    mbedtls_ssl_session_save(const mbedtls_ssl_session*, unsigned char*, size_t, size_t* length) { *length = 0; return 0; }
+inline int    mbedtls_ssl_set_session(mbedtls_ssl_context*, const mbedtls_ssl_session*) { return 0; }
+inline int    mbedtls_ssl_get_session(const mbedtls_ssl_context*, mbedtls_ssl_session*) { return -1; }
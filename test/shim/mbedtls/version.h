@@ -0,0 +1,4 @@
+#pragma once
+#ifndef MBEDTLS_VERSION_NUMBER
+#define MBEDTLS_VERSION_NUMBER 0x03040000 // As in ESP-IDF 5.x, define as 0x021C0300 to build the 2.28 code
+#endif
@@ -0,0 +1,169 @@
+//
+// The shim's state and the parts too large for its headers, SHA-256 for mbedtls_md_hmac() and tinfl over zlib.
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include "esp_now.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "driver/gpio.h"
+#include "mbedtls/md.h"
+#include "esp32/rom/miniz.h"
+#include <zlib.h>
+
+HardwareSerial Serial;
+WiFiClass      WiFi;
+EspClass       ESP;
+uint64_t       EspClass::ShimEfuseMac = 0x0100C40A2400ULL;
+
+unsigned long ShimMillis     = 0;
+int64_t       ShimMicros     = 0;
+uint32_t      ShimMHz        = 240;
+uint32_t      ShimMilliVolts = 4000;
+int           ShimWakeSources = 0;
+int           ShimLightSleeps = 0;
+unsigned long ShimLightSleep  = 1500;
+int           ShimWakeLevel   = 0;
+esp_sleep_wakeup_cause_t ShimWakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+std::vector<std::vector<uint8_t>> ShimSentFrames;
+static uint32_t ShimRandom = 2463534242UL;
+
+unsigned long millis() { return ShimMillis; }
+unsigned long micros() { return ShimMicros; }
+void yield() {}
+void delay(unsigned long ms) {
+  ShimMillis += ms;
+  ShimMicros += (int64_t)ms * 1000;
+}
+esp_err_t esp_light_sleep_start() {
+  ShimLightSleeps++;
+  delay(ShimLightSleep);
+  return ESP_OK;
+}
+uint32_t esp_random() { // xorshift32, so a run is repeatable
+  ShimRandom ^= ShimRandom << 13;
+  ShimRandom ^= ShimRandom >> 17;
+  ShimRandom ^= ShimRandom << 5;
+  return ShimRandom;
+}
+void ShimRandomSeed(uint32_t seed) {
+  ShimRandom = seed ? seed : 2463534242UL;
+}
+
+//#########################################################################################
+// SHA-256, FIPS 180-4
+struct mbedtls_md_info_t { int unused; };
+static const mbedtls_md_info_t Sha256Info = {0};
+
+static const uint32_t Sha256K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+struct Sha256 {
+  uint32_t State[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  uint8_t  Block[64];
+  size_t   Used  = 0;
+  uint64_t Total = 0;
+
+  static uint32_t Rotate(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+  void Compress() {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) w[i] = (uint32_t)Block[4 * i] << 24 | Block[4 * i + 1] << 16 | Block[4 * i + 2] << 8 | Block[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+      uint32_t s0 = Rotate(w[i - 15], 7) ^ Rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = Rotate(w[i - 2], 17) ^ Rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = State[0], b = State[1], c = State[2], d = State[3], e = State[4], f = State[5], g = State[6], h = State[7];
+    for (int i = 0; i < 64; i++) {
+      uint32_t t1 = h + (Rotate(e, 6) ^ Rotate(e, 11) ^ Rotate(e, 25)) + ((e & f) ^ (~e & g)) + Sha256K[i] + w[i];
+      uint32_t t2 = (Rotate(a, 2) ^ Rotate(a, 13) ^ Rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+      h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+    }
+    State[0] += a; State[1] += b; State[2] += c; State[3] += d; State[4] += e; State[5] += f; State[6] += g; State[7] += h;
+  }
+  void Update(const uint8_t* data, size_t length) {
+    Total += length;
+    while (length-- > 0) {
+      Block[Used++] = *data++;
+      if (Used == 64) {
+        Compress();
+        Used = 0;
+      }
+    }
+  }
+  void Finish(uint8_t* digest) {
+    uint64_t bits = Total * 8;
+    uint8_t  pad  = 0x80;
+    Update(&pad, 1);
+    pad = 0;
+    while (Used != 56) Update(&pad, 1);
+    for (int i = 7; i >= 0; i--) Block[Used++] = bits >> (8 * i);
+    Compress();
+    for (int i = 0; i < 32; i++) digest[i] = State[i / 4] >> (24 - 8 * (i % 4));
+  }
+};
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+  return type == MBEDTLS_MD_SHA256 ? &Sha256Info : NULL;
+}
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output) {
+  if (info == NULL) return -1;
+  Sha256 sha;
+  sha.Update(input, length);
+  sha.Finish(output);
+  return 0;
+}
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keyLength, const unsigned char* input, size_t length,
+                    unsigned char* output) {
+  if (info == NULL) return -1;
+  uint8_t block[64] = {0};
+  if (keyLength > 64) mbedtls_md(info, key, keyLength, block);
+  else memcpy(block, key, keyLength);
+  uint8_t pad[64], inner[32];
+  Sha256 sha;
+  for (int i = 0; i < 64; i++) pad[i] = block[i] ^ 0x36;
+  sha.Update(pad, 64);
+  sha.Update(input, length);
+  sha.Finish(inner);
+  Sha256 outer;
+  for (int i = 0; i < 64; i++) pad[i] = block[i] ^ 0x5C;
+  outer.Update(pad, 64);
+  outer.Update(inner, 32);
+  outer.Finish(output);
+  return 0;
+}
+
+//#########################################################################################
+// tinfl_decompress() as http_stream.h calls it, raw deflate into a wrapping dictionary
+tinfl_status tinfl_decompress(tinfl_decompressor* r, const mz_uint8* in, size_t* inSize, mz_uint8*, mz_uint8* out, size_t* outSize,
+                              const mz_uint32 flags) {
+  z_stream* z = (z_stream*)r->m_stream;
+  if (r->m_state == 0) {
+    z = new z_stream();
+    if (inflateInit2(z, (flags & TINFL_FLAG_PARSE_ZLIB_HEADER) ? 15 : -15) != Z_OK) return TINFL_STATUS_FAILED;
+    r->m_stream = z;
+    r->m_state  = 1;
+  }
+  if (r->m_state >= 2) return r->m_state == 2 ? TINFL_STATUS_DONE : TINFL_STATUS_FAILED;
+  z->next_in   = (Bytef*)in;
+  z->avail_in  = *inSize;
+  z->next_out  = out;
+  z->avail_out = *outSize;
+  int result = inflate(z, Z_NO_FLUSH);
+  *inSize  -= z->avail_in;
+  *outSize -= z->avail_out;
+  if (result == Z_STREAM_END || (result != Z_OK && result != Z_BUF_ERROR)) {
+    inflateEnd(z);
+    delete z;
+    r->m_stream = NULL;
+    r->m_state  = result == Z_STREAM_END ? 2 : 3;
+    return result == Z_STREAM_END ? TINFL_STATUS_DONE : TINFL_STATUS_FAILED;
+  }
+  if (z->avail_out == 0) return TINFL_STATUS_HAS_MORE_OUTPUT;
+  return (flags & TINFL_FLAG_HAS_MORE_INPUT) ? TINFL_STATUS_NEEDS_MORE_INPUT : TINFL_STATUS_FAILED;
+}
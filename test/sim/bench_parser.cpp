@@ -0,0 +1,109 @@
+//
+// Throughput and peak heap of the One Call decoders over the responses in corpus/, the streaming parser always
+// and the ArduinoJson decoder when it's built with it. The heap is counted by wrapping malloc and friends, so it
+// includes ArduinoJson's pool and every String the records take, and the parser's own fixed size is added as it
+// lives on the stack. Host figures, for comparing decoders and changes to them, a 240MHz ESP32 is about 20 times
+// slower.
+
+#include <Arduino.h>
+#ifdef HAVE_ARDUINOJSON
+#include <ArduinoJson.h>
+#else
+#define ONECALL_STREAM_PARSER
+#endif
+#include <WiFi.h>
+#include <chrono>
+#include <malloc.h>
+#include <new>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+
+#define BENCH_RUNS 200
+
+//#########################################################################################
+// Heap in use and its peak, by wrapping the allocator (linked with -Wl,--wrap=malloc etc.)
+size_t HeapUsed = 0, HeapPeak = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void  __real_free(void* p);
+void  Allocated(void* p) {
+  if (p == NULL) return;
+  HeapUsed += malloc_usable_size(p);
+  HeapPeak  = max(HeapPeak, HeapUsed);
+}
+void* __wrap_malloc(size_t size) {
+  void* p = __real_malloc(size);
+  Allocated(p);
+  return p;
+}
+void* __wrap_calloc(size_t count, size_t size) {
+  void* p = __real_calloc(count, size);
+  Allocated(p);
+  return p;
+}
+void* __wrap_realloc(void* p, size_t size) {
+  if (p) HeapUsed -= malloc_usable_size(p);
+  void* q = __real_realloc(p, size);
+  Allocated(q ? q : p);
+  return q;
+}
+void __wrap_free(void* p) {
+  if (p) HeapUsed -= malloc_usable_size(p);
+  __real_free(p);
+}
+}
+void* operator new(size_t size) {
+  void* p = malloc(size);
+  if (p == NULL) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+//#########################################################################################
+int main() {
+  struct {
+    const char*       Name;
+    Body_decoder_type Decode;
+    size_t            Stack; // Fixed size of the decoder's state on the stack
+  } decoders[] = {
+#ifdef HAVE_ARDUINOJSON
+    {"ArduinoJson", DecodeOneCallWeather, 0},
+#endif
+    {"Streaming", DecodeOneCallStreamed, sizeof(OneCallParser)},
+  };
+  printf("%-20s %-12s %8s %10s %12s\n", "Response", "Decoder", "Bytes", "MB/s", "Peak heap");
+  for (auto& name : CorpusFiles("onecall_")) {
+    std::string body = ReadFile(CORPUS + name + ".json");
+    for (auto& decoder : decoders) {
+      for (int r = 0; r < max_readings; r++) WxForecast[r] = Forecast_record_type(); // Starts from empty records, as after a boot
+      for (int d = 0; d < 8; d++) Daily[d] = Forecast_record_type();
+      WxConditions[0] = Forecast_record_type();
+      MemoryStream first(body);
+      size_t baseline = HeapUsed;
+      HeapPeak = HeapUsed;
+      if (!decoder.Decode(first, false)) {
+        printf("%s failed to decode %s\n", decoder.Name, name.c_str());
+        return 1;
+      }
+      size_t peak = HeapPeak - baseline + decoder.Stack;
+      auto start = std::chrono::steady_clock::now();
+      for (int run = 0; run < BENCH_RUNS; run++) {
+        MemoryStream stream(body);
+        decoder.Decode(stream, false);
+      }
+      double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      printf("%-20s %-12s %8zu %10.1f %12zu\n", name.c_str(), decoder.Name, body.size(), BENCH_RUNS * body.size() / secs / 1e6, peak);
+    }
+  }
+  printf("OneCallParser is %zu bytes\n", sizeof(OneCallParser));
+  return 0;
+}
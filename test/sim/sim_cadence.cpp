@@ -0,0 +1,147 @@
+//
+// Refreshes against staleness for fixed and adaptive cadences (see cadence.h), over a synthetic year of weather a
+// minute at a time: fronts every two to eight days that drop the pressure and the temperature and raise the chance
+// of rain, on a seasonal and a daily temperature cycle. The forecast a panel decodes is the year's own next 24 hours,
+// so only the cadence is being compared, not forecast error. A panel updates on the 7.5" sketch's schedule, every
+// 30 minutes 07:00 to midnight, skipping the updates within the sleep NextCadence() gives as BeginSleep() does, and
+// is scored over its waking hours by:
+//   the temperature shown against the actual, its 95th percentile and worst error
+//   the minutes rain was likely (PoP 0.5 or more) while a dry forecast was shown
+//   the oldest the display got
+// Each cadence is run with metric and imperial units, which should refresh alike, as an imperial panel decodes the
+// temperatures in F but the forecast pressures in hPa as a metric one does.
+
+#include <Arduino.h>
+#ifdef HAVE_ARDUINOJSON
+#include <ArduinoJson.h>
+#else
+#define ONECALL_STREAM_PARSER
+#endif
+#include <WiFi.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "schedule.h"
+#include "cadence.h"
+
+#define SIM_MINUTES (366 * 24 * 60) // A year and the day of forecast past its end
+#define SIM_START   1767225600      // 2026-01-01 00:00 UTC
+
+std::vector<float> Pressure(SIM_MINUTES), Temperature(SIM_MINUTES), PoP(SIM_MINUTES);
+
+typedef struct {
+  int   Refreshes;
+  float TemperatureP95; // C
+  float TemperatureMax;
+  int   RainLate;       // Minutes
+  int   OldestShown;    // Minutes
+} Score_type;
+
+//#########################################################################################
+void MakeYear() {
+  std::mt19937 random(11);
+  std::normal_distribution<float> noise(0, 1);
+  double pressure = 1015;
+  int    nextFront = 0, frontLeft = 0;
+  float  depth = 0;
+  for (int m = 0; m < SIM_MINUTES; m++) {
+    if (m >= nextFront) { // A front arrives, deepening the low for 12 to 36 hours
+      depth     = 10 + random() % 25;
+      frontLeft = (12 + random() % 24) * 60;
+      nextFront = m + (2 + random() % 7) * 1440;
+    }
+    double target = frontLeft > 0 ? 1015 - depth : 1015;
+    if (frontLeft > 0) frontLeft--;
+    pressure   += (target - pressure) / 600 + noise(random) * 0.01;
+    Pressure[m] = pressure;
+    double day      = m / 1440.0;
+    float  seasonal = 10 - 8 * cos(2 * M_PI * day / 366);
+    float  daily    = -5 * cos(2 * M_PI * (day - floor(day) - 0.125)); // Coldest at 03:00
+    Temperature[m]  = seasonal + daily + (frontLeft > 0 ? -2 : 0) + 0.3 * sin(m / 97.0);
+    float falling   = m >= 120 ? Pressure[m - 120] - Pressure[m] : 0; // hPa in the last two hours
+    PoP[m]          = constrain((1012 - pressure) / 15 + falling * 0.4, 0.0, 1.0);
+  }
+}
+//#########################################################################################
+// Degrees C in the units the panel decodes
+float Decoded(float celsius) {
+  return Units == "I" ? celsius * 9 / 5 + 32 : celsius;
+}
+//#########################################################################################
+Score_type Run(const Cadence_type& cadence) {
+  Schedule_rule_type schedule[] = {{SCHEDULE_EVERY_DAY, 7 * 60, 24 * 60, 30}};
+  Score_type score = {};
+  std::vector<float> errors;
+  float  shownTemperature = 0, shownPoP = 0;
+  int    shownAt = -1, previous = 0;
+  CadenceShown = NAN;
+  for (time_t t = NextScheduledWake(schedule, 1, SIM_START); t > 0;) {
+    int m = (t - SIM_START) / 60;
+    if (m + 24 * 60 >= SIM_MINUTES) break;
+    for (int k = previous; k < m && shownAt >= 0; k++) { // What was shown since the last refresh
+      if (!InSchedule(schedule, 1, SIM_START + k * 60)) continue;
+      errors.push_back(fabs(Temperature[k] - shownTemperature));
+      if (PoP[k] >= 0.5 && shownPoP < 0.5) score.RainLate++;
+      score.OldestShown = max(score.OldestShown, k - shownAt);
+    }
+    WxConditions[0].Temperature = Decoded(Temperature[m]);
+    for (int h = 0; h < max_readings; h++) {
+      WxForecast[h].Pressure    = Pressure[m + h * 60];
+      WxForecast[h].PoP         = PoP[m + h * 60];
+      WxForecast[h].Temperature = Decoded(Temperature[m + h * 60]);
+    }
+    long sleep = NextCadence(cadence);
+    CadenceDisplayed();
+    shownTemperature = Temperature[m];
+    shownPoP         = PoP[m];
+    shownAt          = m;
+    previous         = m;
+    score.Refreshes++;
+    time_t now  = t + 40; // Awake for 40 secs
+    time_t wake = NextScheduledWake(schedule, 1, now), later;
+    while (wake > 0 && (later = NextScheduledWake(schedule, 1, wake)) > 0 && later - now <= sleep * 60 + 60) wake = later;
+    t = wake;
+  }
+  std::sort(errors.begin(), errors.end());
+  score.TemperatureP95 = errors[errors.size() * 95 / 100];
+  score.TemperatureMax = errors.back();
+  return score;
+}
+//#########################################################################################
+int main() {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  MakeYear();
+  Serial.Quiet = true; // NextCadence() logs each sleep
+  struct {
+    const char*  Name;
+    Cadence_type Cadence;
+  } cases[] = {
+    {"fixed 30 min",    {30, 30, 1.0, 0.2, 1.0}},
+    {"fixed 60 min",    {60, 60, 1.0, 0.2, 1.0}},
+    {"adaptive 30-120", {30, 120, 1.0, 0.2, 1.0}}, // The 7.5" sketch's
+    {"looser limits",   {30, 120, 2.0, 0.3, 1.5}},
+  };
+  printf("%-18s %-6s %9s %12s %12s %14s %12s\n", "Cadence", "Units", "Refreshes", "Temp p95 C", "Temp max C", "Rain late min", "Oldest min");
+  bool alike = true;
+  for (auto& c : cases) {
+    int metric = 0;
+    for (const char* units : {"M", "I"}) {
+      Units = units;
+      Score_type score = Run(c.Cadence);
+      printf("%-18s %-6s %9d %12.2f %12.1f %14d %12d\n", c.Name, units, score.Refreshes, score.TemperatureP95, score.TemperatureMax, score.RainLate, score.OldestShown);
+      if (Units == "M") metric = score.Refreshes;
+      else if (score.Refreshes != metric) alike = false;
+    }
+  }
+  Units = "M";
+  if (!alike) printf("Imperial units refresh at a different cadence to metric\n");
+  return alike ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+//
+// Time for a fleet of panels on one schedule to join one access point, with and without stagger.h, over 1000
+// wakes. The access point associates one client at a time, 120 to 300 ms each, and each panel wakes with up-to
+// a few seconds of RTC drift (1.5 s standard deviation) and boots in 250 to 600 ms before it asks to join. A join
+// later than the 4 s WiFi budget (see wake_budget.h) is counted as failed, as the sketch gives up on WiFi then.
+// The panels are a batch of boards with near consecutive MAC addresses, each given its offset by StaggerOffset().
+
+#include <Arduino.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "test.h"
+#include "stagger.h"
+
+#define SIM_WAKES  1000
+#define SIM_SPREAD 1800 // secs, the 7.5" sketch's SleepDuration
+#define SIM_BUDGET 4.0  // secs since waking
+
+//#########################################################################################
+// Returns the offsets of count boards with MAC addresses 24:0A:C4:00:xx:yy from a batch, as getEfuseMac() holds them
+std::vector<uint32_t> FleetOffsets(int count, std::mt19937_64& random) {
+  std::vector<uint32_t> offsets;
+  for (int i = 0; i < count; i++) {
+    uint32_t serial = i * 3 + random() % 2; // Nearly consecutive, as boards from one reel are
+    EspClass::ShimEfuseMac = 0xC40A24ULL | (uint64_t)(serial & 0xFF) << 40 | (uint64_t)(serial >> 8) << 32;
+    offsets.push_back(StaggerOffset(SIM_SPREAD));
+  }
+  return offsets;
+}
+//#########################################################################################
+void Run(int count, bool staggered) {
+  std::mt19937_64 random(1);
+  std::normal_distribution<double>       drift(0, 1.5);
+  std::uniform_real_distribution<double> boot(0.25, 0.6), associate(0.12, 0.3);
+  std::vector<uint32_t> offsets = FleetOffsets(count, random);
+  std::vector<double>   joins;
+  int failed = 0;
+  for (int wake = 0; wake < SIM_WAKES; wake++) {
+    std::vector<std::pair<double, double>> asks; // When each panel asks to join, and when it woke
+    for (int p = 0; p < count; p++) {
+      double woke = (staggered ? offsets[p] : 0) + drift(random);
+      asks.push_back({woke + boot(random), woke});
+    }
+    std::sort(asks.begin(), asks.end());
+    double free = -1e9; // When the access point is next free
+    for (auto& ask : asks) {
+      free = max(ask.first, free) + associate(random);
+      double join = free - ask.second;
+      if (join > SIM_BUDGET) failed++;
+      joins.push_back(join);
+    }
+  }
+  std::sort(joins.begin(), joins.end());
+  printf("%6d %-9s %8.2f %8.2f %8.2f %9.1f%%\n", count, staggered ? "on" : "off", joins[joins.size() / 2],
+         joins[joins.size() * 95 / 100], joins.back(), 100.0 * failed / joins.size());
+}
+//#########################################################################################
+int main() {
+  Serial.Quiet = true; // StaggerOffset() logs each offset
+  printf("%6s %-9s %8s %8s %8s %10s\n", "Panels", "Stagger", "p50 s", "p95 s", "max s", "Over 4s");
+  for (int count : {10, 30, 100}) {
+    Run(count, false);
+    Run(count, true);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+//
+// Checks and helpers shared by the host tests. Each test is a program that runs its checks, prints those that
+// fail, and exits non-zero if any did. Files are read from test/corpus, as the tests are run from test/.
+
+#pragma once
+#include <Arduino.h>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define CORPUS "corpus/"
+
+int TestChecks   = 0;
+int TestFailures = 0;
+
+#define CHECK(condition) TestCheck((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(value, expected, tolerance) TestNear((value), (expected), (tolerance), #value, __FILE__, __LINE__)
+
+bool TestCheck(bool passed, const char* what, const char* file, int line) {
+  TestChecks++;
+  if (!passed) {
+    TestFailures++;
+    fprintf(stderr, "%s:%d: failed: %s\n", file, line, what);
+  }
+  return passed;
+}
+
+bool TestNear(double value, double expected, double tolerance, const char* what, const char* file, int line) {
+  TestChecks++;
+  if (fabs(value - expected) <= tolerance) return true;
+  TestFailures++;
+  fprintf(stderr, "%s:%d: failed: %s is %.6g, expected %.6g +/- %g\n", file, line, what, value, expected, tolerance);
+  return false;
+}
+
+int TestResult(const char* name) {
+  printf("%s: %d checks, %d failed\n", name, TestChecks, TestFailures);
+  return TestFailures > 0 ? 1 : 0;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    fprintf(stderr, "Can't read %s\n", path.c_str());
+    exit(2);
+  }
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+// Names of the corpus files starting with prefix and ending .json, without the .json, sorted
+std::vector<std::string> CorpusFiles(const char* prefix) {
+  std::vector<std::string> names;
+  DIR* folder = opendir(CORPUS);
+  if (folder == NULL) return names;
+  while (dirent* entry = readdir(folder)) {
+    std::string name = entry->d_name;
+    if (name.rfind(prefix, 0) == 0 && name.size() > 5 && name.substr(name.size() - 5) == ".json") names.push_back(name.substr(0, name.size() - 5));
+  }
+  closedir(folder);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// A response body as the decoders read it from the network, optionally in short reads
+class MemoryStream : public Stream {
+  public:
+    MemoryStream(const std::string& data, size_t chunk = 0) : _data(data), _position(0), _chunk(chunk) {}
+    int available() override {
+      size_t left = _data.size() - _position;
+      return _chunk > 0 ? min(left, _chunk) : left;
+    }
+    int read() override { return _position < _data.size() ? (uint8_t)_data[_position++] : -1; }
+    int peek() override { return _position < _data.size() ? (uint8_t)_data[_position] : -1; }
+    size_t readBytes(char* buffer, size_t length) override {
+      length = min(length, _data.size() - _position);
+      memcpy(buffer, _data.data() + _position, length);
+      _position += length;
+      Reads++;
+      return length;
+    }
+    size_t write(uint8_t) override { return 0; }
+    size_t Position() { return _position; }
+    size_t Reads = 0; // Calls to readBytes()
+  private:
+    std::string _data;
+    size_t      _position;
+    size_t      _chunk;
+};
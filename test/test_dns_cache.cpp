@@ -0,0 +1,90 @@
+//
+// Checks that the resolver cache takes an address and TTL only from a real answer to its own query.
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+#include "test.h"
+
+#include "wake_metrics.h"
+#include "dns_cache.h"
+
+typedef std::vector<uint8_t> Packet_type;
+
+//#########################################################################################
+// A query as QueryDns() sends it, for api.openweathermap.org
+Packet_type Query(uint16_t id, const char* name = "\x03" "api" "\x0e" "openweathermap" "\x03" "org") {
+  Packet_type query = {(uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0};
+  query.insert(query.end(), name, name + strlen(name) + 1);
+  query.insert(query.end(), {0, 1, 0, 1});
+  return query;
+}
+//#########################################################################################
+// An answer to query, a CNAME with ttl1 and then an A record with ttl2
+Packet_type Answer(const Packet_type& query, uint32_t ttl1, uint32_t ttl2) {
+  Packet_type answer = query;
+  answer[2] = 0x81; // Response, recursion desired
+  answer[3] = 0x80; // Recursion available, no error
+  answer[7] = 2;    // Two answers
+  const uint8_t cname[] = {0xC0, 0x0C, 0, 5, 0, 1, (uint8_t)(ttl1 >> 24), (uint8_t)(ttl1 >> 16), (uint8_t)(ttl1 >> 8), (uint8_t)ttl1, 0, 4, 2, 'l', 'b', 0};
+  answer.insert(answer.end(), cname, cname + sizeof(cname));
+  uint8_t at = query.size() + 12; // Offset of the CNAME's target name
+  const uint8_t a[] = {0xC0, at, 0, 1, 0, 1, (uint8_t)(ttl2 >> 24), (uint8_t)(ttl2 >> 16), (uint8_t)(ttl2 >> 8), (uint8_t)ttl2, 0, 4, 203, 0, 113, 7};
+  answer.insert(answer.end(), a, a + sizeof(a));
+  return answer;
+}
+//#########################################################################################
+bool Read(const Packet_type& answer, const Packet_type& query, IPAddress& ip, uint32_t& ttl) {
+  ip  = IPAddress();
+  ttl = 0;
+  return ReadDnsAnswer(answer.data(), answer.size(), query.data(), query.size(), ip, ttl);
+}
+//#########################################################################################
+int main() {
+  IPAddress ip;
+  uint32_t  ttl;
+  Packet_type query  = Query(0x1234);
+  Packet_type answer = Answer(query, 300, 60);
+  CHECK(Read(answer, query, ip, ttl) && ip == IPAddress(203, 0, 113, 7) && ttl == 60);
+  CHECK(Read(Answer(query, 30, 600), query, ip, ttl) && ttl == 30); // The lowest TTL of the chain
+
+  Packet_type request = answer;
+  request[2] &= ~0x80; // QR clear, e.g. our own query reflected back
+  CHECK(!Read(request, query, ip, ttl));
+
+  Packet_type otherId = answer;
+  otherId[1] ^= 1;
+  CHECK(!Read(otherId, query, ip, ttl));
+
+  Packet_type failed = answer;
+  failed[3] |= 3; // NXDOMAIN
+  CHECK(!Read(failed, query, ip, ttl));
+
+  Packet_type otherName = Answer(Query(0x1234, "\x03" "api" "\x0e" "openweathermbp" "\x03" "org"), 300, 60);
+  CHECK(!Read(otherName, query, ip, ttl)); // Same ID, but the answer to another question
+
+  Packet_type otherType = answer;
+  otherType[query.size() - 3] = 28; // AAAA
+  CHECK(!Read(otherType, query, ip, ttl));
+
+  Packet_type twoQuestions = answer;
+  twoQuestions[5] = 2;
+  CHECK(!Read(twoQuestions, query, ip, ttl));
+
+  Packet_type mixedCase = answer;
+  mixedCase[13] = 'A'; // DNS 0x20, a resolver may change the case of the name
+  CHECK(Read(mixedCase, query, ip, ttl) && ip == IPAddress(203, 0, 113, 7));
+
+  for (size_t cut = 0; cut < answer.size(); cut++) { // A packet cut short anywhere gives no address
+    Packet_type shorter(answer.begin(), answer.begin() + cut);
+    CHECK(!Read(shorter, query, ip, ttl));
+  }
+
+  Packet_type noAddress = answer;
+  noAddress[7] = 1; // Only the CNAME
+  noAddress.resize(query.size() + 16);
+  CHECK(!Read(noAddress, query, ip, ttl));
+
+  CHECK(HostHash("API.OpenWeatherMap.org") == HostHash("api.openweathermap.org"));
+  return TestResult("test_dns_cache");
+}
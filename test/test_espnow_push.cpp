@@ -0,0 +1,170 @@
+//
+// ESP-NOW push framing, authentication and replay checks, by passing frames from PushFrame() and SendPush() to a
+// PushAssembler directly: a message arrives whole over a lossy, reordered channel shared with other places, forged
+// and old frames, and nothing tampered with, cut short, for another place or seen before is ever accepted.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "wire_format.h"
+#include "espnow_push.h"
+
+typedef std::vector<uint8_t>    Bytes_type;
+typedef std::vector<Bytes_type> Frames_type;
+
+const char Key[] = "shared push key";
+
+//#########################################################################################
+Frames_type Frames(const Bytes_type& message, uint32_t sequence, uint32_t place, const char* key = Key) {
+  Frames_type frames;
+  for (int f = 0; f < PushFrameCount(message.size()); f++) {
+    uint8_t frame[PUSH_FRAME_SIZE];
+    size_t  length = PushFrame(frame, message.data(), message.size(), f, sequence, place, (const uint8_t*)key, strlen(key));
+    frames.emplace_back(frame, frame + length);
+  }
+  return frames;
+}
+//#########################################################################################
+Push_result_type AddAll(PushAssembler& assembler, const Frames_type& frames) {
+  Push_result_type result = PUSH_PENDING;
+  for (auto& frame : frames) result = assembler.Add(frame.data(), frame.size());
+  return result;
+}
+//#########################################################################################
+Bytes_type Hex(const char* text) {
+  Bytes_type bytes;
+  for (; text[0] && text[1]; text += 2) bytes.push_back(strtol(std::string(text, 2).c_str(), NULL, 16));
+  return bytes;
+}
+//#########################################################################################
+// The tag is the start of HMAC-SHA256, checked against RFC 4231 test cases 1, 2 and 6
+void TestTag() {
+  struct {
+    Bytes_type  Key;
+    std::string Data;
+    const char* Hmac;
+  } cases[] = {
+    {Bytes_type(20, 0x0b), "Hi There", "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"},
+    {Bytes_type({'J', 'e', 'f', 'e'}), "what do ya want for nothing?", "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"},
+    {Bytes_type(131, 0xaa), "Test Using Larger Than Block-Size Key - Hash Key First", "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"},
+  };
+  for (auto& test : cases) {
+    uint8_t tag[PUSH_TAG_SIZE];
+    PushTag(test.Key.data(), test.Key.size(), (const uint8_t*)test.Data.data(), test.Data.size(), tag);
+    Bytes_type hmac = Hex(test.Hmac);
+    TestCheck(memcmp(tag, hmac.data(), PUSH_TAG_SIZE) == 0, ("HMAC of '" + test.Data + "'").c_str(), __FILE__, __LINE__);
+  }
+}
+//#########################################################################################
+void TestFraming(const Bytes_type& wire) {
+  CHECK(PushFrameCount(0) == 1 && PushFrameCount(PUSH_DATA_SIZE) == 1 && PushFrameCount(PUSH_DATA_SIZE + 1) == 2);
+  Frames_type frames = Frames(wire, 1700000000, 7);
+  CHECK((int)frames.size() == PushFrameCount(wire.size()) && frames.size() <= 3); // A forecast without texts fits in three
+  Bytes_type joined;
+  for (size_t f = 0; f < frames.size(); f++) {
+    const Bytes_type& frame = frames[f];
+    CHECK(frame.size() <= PUSH_FRAME_SIZE && frame[0] == 'W' && frame[1] == 'N' && frame[2] == PUSH_VERSION);
+    CHECK(frame[3] == f && frame[4] == frames.size() && PushReadU32(&frame[5]) == 1700000000 && PushReadU32(&frame[9]) == 7);
+    size_t length = frame[13] | frame[14] << 8, data = frame[15];
+    CHECK(length == wire.size() && frame.size() == PUSH_HEADER_SIZE + data + PUSH_TAG_SIZE);
+    joined.insert(joined.end(), frame.begin() + PUSH_HEADER_SIZE, frame.end() - PUSH_TAG_SIZE);
+  }
+  CHECK(joined == wire);
+
+  PushAssembler assembler((const uint8_t*)Key, strlen(Key), 7, 0);
+  Frames_type reversed(frames.rbegin(), frames.rend());
+  CHECK(AddAll(assembler, reversed) == PUSH_COMPLETE && assembler.Sequence() == 1700000000);
+  CHECK(Bytes_type(assembler.Message(), assembler.Message() + assembler.Length()) == wire);
+  CHECK(DecodeWire(assembler.Message(), assembler.Length()));
+}
+//#########################################################################################
+void TestRejected(const Bytes_type& wire) {
+  Frames_type frames = Frames(wire, 1700000100, 7);
+  PushAssembler assembler((const uint8_t*)Key, strlen(Key), 7, 1700000000);
+  CHECK(AddAll(assembler, frames) == PUSH_COMPLETE);
+  for (auto& frame : frames) CHECK(assembler.Add(frame.data(), frame.size()) == PUSH_REPLAYED); // The same message again
+  Frames_type older = Frames(wire, 1700000050, 7);
+  CHECK(assembler.Add(older[0].data(), older[0].size()) == PUSH_REPLAYED);
+  PushAssembler fresh((const uint8_t*)Key, strlen(Key), 7, 1700000100); // As after the next wake, from PushLastSequence
+  CHECK(fresh.Add(frames[0].data(), frames[0].size()) == PUSH_REPLAYED);
+
+  Frames_type other = Frames(wire, 1700000200, 8);
+  CHECK(fresh.Add(other[0].data(), other[0].size()) == PUSH_OTHER_PLACE);
+  Frames_type forged = Frames(wire, 1700000200, 7, "another key");
+  CHECK(fresh.Add(forged[0].data(), forged[0].size()) == PUSH_BAD_TAG);
+
+  Frames_type next = Frames(wire, 1700000200, 7);
+  for (size_t at = 0; at < next[0].size(); at++) { // Any change to a frame is caught, by the framing checks or the tag
+    for (uint8_t bit : {0x01, 0x80}) {
+      Bytes_type tampered = next[0];
+      tampered[at] ^= bit;
+      Push_result_type result = fresh.Add(tampered.data(), tampered.size());
+      TestCheck(result == PUSH_BAD_FRAME || result == PUSH_BAD_TAG, ("tampered at " + std::to_string(at)).c_str(), __FILE__, __LINE__);
+    }
+  }
+  for (size_t length = 0; length < next[1].size(); length++) CHECK(fresh.Add(next[1].data(), length) == PUSH_BAD_FRAME);
+  Bytes_type longer = next[1];
+  longer.push_back(0);
+  CHECK(fresh.Add(longer.data(), longer.size()) == PUSH_BAD_FRAME);
+  CHECK(AddAll(fresh, next) == PUSH_COMPLETE); // Nothing rejected was kept
+  CHECK(Bytes_type(fresh.Message(), fresh.Message() + fresh.Length()) == wire);
+}
+//#########################################################################################
+// Three broadcasts each losing a quarter of its frames, reordered among broadcasts for another place, forged
+// frames and a recording of an old one. Whatever completes must be the message sent.
+void TestLossyChannel(const Bytes_type& wire) {
+  std::mt19937 random(1);
+  int completed = 0, wrong = 0, trials = 2000;
+  for (int t = 0; t < trials; t++) {
+    Frames_type channel;
+    for (int repeat = 0; repeat < 3; repeat++) {
+      for (auto& frame : Frames(wire, 1700000300 + repeat, 7)) if (random() % 4) channel.push_back(frame);
+      for (auto& frame : Frames(wire, 1700000300 + repeat, 8)) channel.push_back(frame);
+      for (auto& frame : Frames(wire, 1800000000, 7, "another key")) channel.push_back(frame);
+      for (auto& frame : Frames(wire, 1600000000, 7)) channel.push_back(frame);
+    }
+    std::shuffle(channel.begin(), channel.end(), random);
+    PushAssembler assembler((const uint8_t*)Key, strlen(Key), 7, 1700000000);
+    for (auto& frame : channel) {
+      if (assembler.Add(frame.data(), frame.size()) != PUSH_COMPLETE) continue;
+      completed++;
+      if (Bytes_type(assembler.Message(), assembler.Message() + assembler.Length()) != wire) wrong++;
+      break;
+    }
+  }
+  printf("Lossy channel: %d of %d messages completed, %d wrong\n", completed, trials, wrong);
+  CHECK(wrong == 0 && completed > trials / 3); // About half, as a newer broadcast drops what's held of an older one
+}
+//#########################################################################################
+void TestSendPush(const Bytes_type& wire) {
+  ShimSentFrames.clear();
+  CHECK(SendPush(Key, wire.data(), wire.size(), 7));
+  CHECK((int)ShimSentFrames.size() == PushFrameCount(wire.size()));
+  PushAssembler assembler((const uint8_t*)Key, strlen(Key), 7, 0);
+  CHECK(AddAll(assembler, ShimSentFrames) == PUSH_COMPLETE);
+  CHECK(Bytes_type(assembler.Message(), assembler.Message() + assembler.Length()) == wire);
+  CHECK(!SendPush(Key, wire.data(), PUSH_MAX_MESSAGE + 1, 7));
+}
+//#########################################################################################
+int main() {
+  MemoryStream json(ReadFile(CORPUS "onecall_bath.json"));
+  CHECK(DecodeOneCallStreamed(json, false));
+  Bytes_type wire(WIRE_MAX_SIZE);
+  wire.resize(EncodeWire(wire.data(), wire.size(), false));
+  TestTag();
+  TestFraming(wire);
+  TestRejected(wire);
+  TestLossyChannel(wire);
+  TestSendPush(wire);
+  return TestResult("test_espnow_push");
+}
@@ -0,0 +1,145 @@
+//
+// Checks that a body is buffered whole when it fits, and that a chunked or gzip body of unknown length that
+// outgrows the buffer is still decoded whole, as it arrives after the part already buffered. Reads of a body
+// are to take whole chunks or Content-Length from the connection at a time, and stop at the end of the body.
+
+#include <Arduino.h>
+#include <zlib.h>
+#include "test.h"
+#include "http_stream.h"
+
+std::string Body;          // What the decoders should read
+int         DecodeCalls = 0;
+
+//#########################################################################################
+std::string Text(size_t size) {
+  std::string text;
+  for (size_t i = 0; text.size() < size; i++) text += "{\"dt\":" + std::to_string(1700000000 + i * 3600) + "},";
+  text.resize(size);
+  return text;
+}
+//#########################################################################################
+std::string Chunked(const std::string& body, size_t chunk) {
+  std::string framed;
+  for (size_t at = 0; at < body.size(); at += chunk) {
+    std::string part = body.substr(at, chunk);
+    char size[16];
+    snprintf(size, sizeof(size), "%zx\r\n", part.size());
+    framed += size + part + "\r\n";
+  }
+  return framed + "0\r\n\r\n";
+}
+//#########################################################################################
+std::string Gzipped(const std::string& body) {
+  z_stream z = {};
+  deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY); // 16 asks for a gzip wrapper
+  std::string out(deflateBound(&z, body.size()), 0);
+  z.next_in   = (Bytef*)body.data();
+  z.avail_in  = body.size();
+  z.next_out  = (Bytef*)&out[0];
+  z.avail_out = out.size();
+  deflate(&z, Z_FINISH);
+  out.resize(z.total_out);
+  deflateEnd(&z);
+  return out;
+}
+//#########################################################################################
+// A decoder that succeeds only if it reads exactly the whole body
+bool ReadsWholeBody(Stream& body, bool) {
+  DecodeCalls++;
+  std::string got;
+  for (int c; (c = body.read()) >= 0;) got += (char)c;
+  return got == Body;
+}
+//#########################################################################################
+bool Decode(Stream& body, int length) {
+  Body_decoder_type decoders[] = {ReadsWholeBody, ReadsWholeBody};
+  DecodeCalls = 0;
+  return DecodeBufferedBody(body, length, decoders, 2, false);
+}
+//#########################################################################################
+void TestReadBody() {
+  size_t size;
+  bool   truncated;
+  Body = Text(HTTP_BUFFER_LIMIT + 1000);
+  MemoryStream large(Body);
+  uint8_t* buffer = ReadBody(large, -1, size, &truncated);
+  CHECK(buffer != NULL && truncated && size == HTTP_BUFFER_LIMIT);
+  CHECK(buffer != NULL && memcmp(buffer, Body.data(), size) == 0);
+  CHECK(large.Position() == HTTP_BUFFER_LIMIT); // The rest is left to be read
+  free(buffer);
+
+  Body = Text(HTTP_BUFFER_LIMIT);
+  MemoryStream exact(Body);
+  buffer = ReadBody(exact, -1, size, &truncated);
+  CHECK(buffer != NULL && !truncated && size == HTTP_BUFFER_LIMIT);
+  free(buffer);
+
+  Body = Text(5000);
+  MemoryStream known(Body);
+  buffer = ReadBody(known, Body.size(), size, &truncated);
+  CHECK(buffer != NULL && !truncated && size == Body.size());
+  free(buffer);
+
+  MemoryStream tooLarge(Body);
+  CHECK(ReadBody(tooLarge, HTTP_BUFFER_LIMIT + 1, size, &truncated) == NULL && tooLarge.Position() == 0);
+}
+//#########################################################################################
+void TestDecodeBufferedBody() {
+  for (size_t length : {(size_t)100, (size_t)HTTP_BUFFER_STEP * 3, (size_t)HTTP_BUFFER_LIMIT, (size_t)HTTP_BUFFER_LIMIT * 3 + 17}) {
+    Body = Text(length);
+    std::string what = std::to_string(length) + " byte ";
+
+    MemoryStream plain(Body, 512);
+    TestCheck(Decode(plain, Body.size()) || length > HTTP_BUFFER_LIMIT, (what + "body of known length").c_str(), __FILE__, __LINE__);
+
+    MemoryStream chunkedSource(Chunked(Body, 1460), 512);
+    HttpBodyStream chunked(chunkedSource, -1, true);
+    TestCheck(Decode(chunked, -1) && DecodeCalls == 1, (what + "chunked body").c_str(), __FILE__, __LINE__);
+    TestCheck(chunked.Drain(), (what + "chunked body ended cleanly").c_str(), __FILE__, __LINE__);
+
+    MemoryStream gzipSource(Gzipped(Body), 512);
+    GzipStream gzip(gzipSource);
+    TestCheck(Decode(gzip, -1) && DecodeCalls == 1, (what + "gzip body").c_str(), __FILE__, __LINE__);
+    TestCheck(gzip.InflatedBytes() == Body.size(), (what + "gzip body inflated").c_str(), __FILE__, __LINE__);
+  }
+  Body = Text(HTTP_BUFFER_LIMIT * 2);
+  MemoryStream known(Body);
+  CHECK(Decode(known, Body.size()) && DecodeCalls == 1); // Known to be too large, so not buffered at all
+}
+//#########################################################################################
+// Reads the body in pieces of size after a peek, and checks it's whole, and read in bulk unless size is 1
+void ExpectBulkRead(MemoryStream& source, HttpBodyStream& body, size_t size, const std::string& what) {
+  std::string got, piece(size, 0);
+  size_t n;
+  got += (char)body.peek();
+  while ((n = body.readBytes(&piece[0], size)) > 0) got += piece.substr(0, n);
+  got.erase(0, 1); // readBytes() returns the peeked byte first
+  TestCheck(got == Body, (what + " read whole").c_str(), __FILE__, __LINE__);
+  TestCheck(size == 1 || source.Reads < Body.size() / 100, (what + " read in bulk, " + std::to_string(source.Reads) + " reads").c_str(), __FILE__, __LINE__);
+  TestCheck(body.Drain() && body.read() < 0, (what + " ended").c_str(), __FILE__, __LINE__);
+}
+//#########################################################################################
+void TestBulkRead() {
+  const std::string next = "HTTP/1.1 200 OK\r\n";
+  Body = Text(20000);
+  for (size_t size : {(size_t)1, (size_t)700, (size_t)4096, (size_t)30000}) {
+    std::string what = std::to_string(size) + " byte reads of a ";
+    MemoryStream knownSource(Body + next);
+    HttpBodyStream known(knownSource, Body.size(), false);
+    ExpectBulkRead(knownSource, known, size, what + "body of known length");
+    TestCheck(knownSource.Position() == Body.size(), (what + "body of known length left the next response").c_str(), __FILE__, __LINE__);
+
+    MemoryStream chunkedSource(Chunked(Body, 1460) + next);
+    HttpBodyStream chunked(chunkedSource, -1, true);
+    ExpectBulkRead(chunkedSource, chunked, size, what + "chunked body");
+    TestCheck(chunkedSource.Position() == Chunked(Body, 1460).size(), (what + "chunked body left the next response").c_str(), __FILE__, __LINE__);
+  }
+}
+//#########################################################################################
+int main() {
+  TestBulkRead();
+  TestReadBody();
+  TestDecodeBufferedBody();
+  return TestResult("test_http_stream");
+}
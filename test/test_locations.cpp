@@ -0,0 +1,92 @@
+//
+// Checks that loading a location's record restores every field the wire format carries, and leaves nothing of
+// the location loaded before it, with the descriptions the record doesn't keep cleared.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#define FETCH_TLS // So tls_client.h is built too
+#include "common.h"
+#include "http_fetch.h"
+#include "wire_format.h"
+#include "locations.h"
+
+typedef struct {
+  Forecast_record_type Current;
+  Forecast_record_type Hours[max_readings];
+  Forecast_record_type Days[8];
+} Decoded_type;
+
+//#########################################################################################
+Decoded_type Decode(const std::string& name) {
+  MemoryStream json(ReadFile(CORPUS + name + ".json"));
+  TestCheck(DecodeOneCallStreamed(json, false), (name + " decoded").c_str(), __FILE__, __LINE__);
+  Decoded_type decoded;
+  decoded.Current = WxConditions[0];
+  for (int r = 0; r < max_readings; r++) decoded.Hours[r] = WxForecast[r];
+  for (int d = 0; d < 8; d++) decoded.Days[d] = Daily[d];
+  return decoded;
+}
+//#########################################################################################
+// The records hold what was decoded, to the wire format's precision, without the descriptions
+void CheckLoaded(const Decoded_type& expected) {
+  const Forecast_record_type& e = expected.Current;
+  Forecast_record_type&       c = WxConditions[0];
+  CHECK(c.Timezone == e.Timezone && c.Sunrise == e.Sunrise && c.Sunset == e.Sunset);
+  CHECK_NEAR(c.Temperature, e.Temperature, 0.005);
+  CHECK_NEAR(c.FeelsLike, e.FeelsLike, 0.005);
+  CHECK_NEAR(c.Pressure, e.Pressure, 0.005);
+  CHECK_NEAR(c.DewPoint, e.DewPoint, 0.005);
+  CHECK_NEAR(c.UVI, e.UVI, 0.005);
+  CHECK_NEAR(c.Windspeed, e.Windspeed, 0.005);
+  CHECK(c.Icon == e.Icon && c.Trend == e.Trend && c.Description == "");
+  for (int r = 0; r < max_readings; r++) {
+    const Forecast_record_type& h = expected.Hours[r];
+    CHECK(WxForecast[r].Dt == h.Dt && WxForecast[r].Icon == h.Icon);
+    CHECK_NEAR(WxForecast[r].Temperature, h.Temperature, 0.005);
+    CHECK_NEAR(WxForecast[r].FeelsLike, h.FeelsLike, 0.005);
+    CHECK_NEAR(WxForecast[r].DewPoint, h.DewPoint, 0.005);
+    CHECK_NEAR(WxForecast[r].Pressure, h.Pressure, 0.005);
+    CHECK_NEAR(WxForecast[r].PoP, h.PoP, 0.005);
+    CHECK_NEAR(WxForecast[r].Rainfall, h.Rainfall, 0.005);
+  }
+  for (int d = 0; d < 8; d++) {
+    const Forecast_record_type& day = expected.Days[d];
+    CHECK(Daily[d].Dt == day.Dt && Daily[d].Icon == day.Icon && Daily[d].Description == "");
+    CHECK_NEAR(Daily[d].High, day.High, 0.005);
+    CHECK_NEAR(Daily[d].Low, day.Low, 0.005);
+    CHECK_NEAR(Daily[d].PoP, day.PoP, 0.005);
+  }
+}
+//#########################################################################################
+int main() {
+  std::vector<std::string> names = CorpusFiles("onecall_");
+  CHECK(names.size() >= 2);
+  std::vector<Decoded_type> decoded;
+  for (size_t l = 0; l < names.size() && l < LOCATION_MAX; l++) {
+    decoded.push_back(Decode(names[l]));
+    StoreLocation(l);
+    CHECK(LocationRecords[l].Fetched != 0 && LocationRecords[l].Size > 0 && LocationRecords[l].Size <= LOCATION_WIRE_SIZE);
+    printf("%s: %u of %d bytes of a location record\n", names[l].c_str(), LocationRecords[l].Size, LOCATION_WIRE_SIZE);
+  }
+  for (size_t l = 0; l < decoded.size(); l++) { // Each over the one loaded before it
+    CHECK(LoadLocation(l));
+    CheckLoaded(decoded[l]);
+  }
+  CHECK(LoadLocation(1));
+  CheckLoaded(decoded[1]);
+
+  LocationRecords[0].Wire[LocationRecords[0].Size / 2] ^= 1; // Damaged, so not loaded, and the records unchanged
+  CHECK(!LoadLocation(0));
+  CheckLoaded(decoded[1]);
+  LocationRecords[3].Fetched = 0;
+  CHECK(!LoadLocation(3));
+  return TestResult("test_locations");
+}
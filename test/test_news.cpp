@@ -0,0 +1,76 @@
+//
+// Decodes the news feeds in corpus/ and checks the headlines kept against the .expected file beside each feed,
+// made by corpus/make_corpus.py: an empty feed, titles cut across a multi-byte character, missing and null fields,
+// more articles than are kept, and a feed larger than NEWS_MAX_BODY. Needs ArduinoJson.
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <map>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "news.h"
+
+//#########################################################################################
+// True if text is whole UTF-8 characters, as the display's font renderer needs
+bool WholeUtf8(const char* text) {
+  for (const uint8_t* c = (const uint8_t*)text; *c;) {
+    int bytes = *c < 0x80 ? 1 : *c >= 0xF0 ? 4 : *c >= 0xE0 ? 3 : *c >= 0xC0 ? 2 : 0;
+    if (bytes == 0) return false;
+    for (int b = 1; b < bytes; b++) {
+      if ((c[b] & 0xC0) != 0x80) return false;
+    }
+    c += bytes;
+  }
+  return true;
+}
+//#########################################################################################
+void TestCopyUtf8() {
+  char buffer[8];
+  CHECK(CopyUtf8(buffer, "short", sizeof(buffer)) == 5 && strcmp(buffer, "short") == 0);
+  CHECK(CopyUtf8(buffer, "exactly", sizeof(buffer)) == 7 && strcmp(buffer, "exactly") == 0);
+  CHECK(CopyUtf8(buffer, "abcde\xE2\x80\x93", sizeof(buffer)) == 5 && strcmp(buffer, "abcde") == 0); // An en dash across the cut
+  CHECK(CopyUtf8(buffer, "abcd\xE2\x80\x93z", sizeof(buffer)) == 7 && strcmp(buffer, "abcd\xE2\x80\x93") == 0); // Ends exactly at it
+  CHECK(CopyUtf8(buffer, "abcdef\xC3\xA9", sizeof(buffer)) == 6 && strcmp(buffer, "abcdef") == 0);
+  CHECK(CopyUtf8(buffer, "abc\xF0\x9F\x98\x80xyz", sizeof(buffer)) == 7 && strcmp(buffer, "abc\xF0\x9F\x98\x80") == 0);
+  CHECK(CopyUtf8(buffer, "abcd\xF0\x9F\x98\x80", sizeof(buffer)) == 4 && strcmp(buffer, "abcd") == 0);
+}
+//#########################################################################################
+void TestFeed(const std::string& name) {
+  std::map<std::string, std::string> expected;
+  std::stringstream lines(ReadFile(CORPUS + name + ".expected"));
+  for (std::string line; std::getline(lines, line);) {
+    size_t equals = line.find('=');
+    if (equals != std::string::npos) expected[line.substr(0, equals)] = line.substr(equals + 1);
+  }
+  MemoryStream body(ReadFile(CORPUS + name + ".json"), 64);
+  bool decoded = DecodeNewsHeadlines(body, false);
+  std::string what = name + " ";
+  TestCheck(decoded == (expected["decoded"] == "1"), (what + "decoded").c_str(), __FILE__, __LINE__);
+  TestCheck(HeadlineCount == atoi(expected["count"].c_str()), (what + "headline count " + std::to_string(HeadlineCount)).c_str(), __FILE__, __LINE__);
+  for (int h = 0; h < HeadlineCount; h++) {
+    std::string title  = expected["title" + std::to_string(h)];
+    std::string source = expected["source" + std::to_string(h)];
+    TestCheck(title == Headlines[h].Title, (what + "title " + Headlines[h].Title).c_str(), __FILE__, __LINE__);
+    TestCheck(source == Headlines[h].Source, (what + "source " + Headlines[h].Source).c_str(), __FILE__, __LINE__);
+    TestCheck(WholeUtf8(Headlines[h].Title) && WholeUtf8(Headlines[h].Source), (what + "whole characters").c_str(), __FILE__, __LINE__);
+  }
+}
+//#########################################################################################
+int main() {
+  TestCopyUtf8();
+  std::vector<std::string> names = CorpusFiles("news_");
+  CHECK(names.size() > 0);
+  for (auto& name : names) TestFeed(name);
+  {
+    MemoryStream body("{\"status\":\"error\",\"code\":\"apiKeyInvalid\"}");
+    CHECK(!DecodeNewsHeadlines(body, false) && HeadlineCount == 0);
+  }
+  return TestResult("test_news");
+}
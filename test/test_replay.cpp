@@ -0,0 +1,119 @@
+//
+// Replays the One Call responses in corpus/ through the decoders, and checks every field each leaves in the
+// records against the .expected file beside the response, numbers to within a tolerance, as both decoders store
+// floats and ArduinoJson and the streaming parser round the last digit differently. Without ArduinoJson only the
+// streaming decoder is checked. Add a captured response by saving it as corpus/onecall_<name>.json and writing its
+// expectations with corpus/make_corpus.py.
+
+#include <Arduino.h>
+#ifdef HAVE_ARDUINOJSON
+#include <ArduinoJson.h>
+#else
+#define ONECALL_STREAM_PARSER
+#endif
+#include <WiFi.h>
+#include <map>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+
+typedef std::map<std::string, std::string> Fields_type;
+
+//#########################################################################################
+// The records as key=value pairs, with the keys of make_corpus.py
+Fields_type RecordFields() {
+  Fields_type fields;
+  auto number = [&](const std::string& key, double value) { char text[32]; snprintf(text, sizeof(text), "%.6f", value); fields[key] = text; };
+  Forecast_record_type& c = WxConditions[0];
+  number("tz", c.Timezone);
+  fields["c.description"] = c.Description.c_str();
+  fields["c.icon"]        = c.Icon.c_str();
+  number("c.sunrise", c.Sunrise);       number("c.sunset", c.Sunset);       number("c.temp", c.Temperature);
+  number("c.feels_like", c.FeelsLike);  number("c.pressure", c.Pressure);   number("c.humidity", c.Humidity);
+  number("c.dew_point", c.DewPoint);    number("c.uvi", c.UVI);             number("c.clouds", c.Cloudcover);
+  number("c.visibility", c.Visibility); number("c.wind_speed", c.Windspeed); number("c.wind_deg", c.Winddir);
+  for (int r = 0; r < max_readings; r++) {
+    Forecast_record_type& h = WxForecast[r];
+    std::string k = "h" + std::to_string(r) + ".";
+    number(k + "dt", h.Dt);                number(k + "temp", h.Temperature); number(k + "feels_like", h.FeelsLike);
+    number(k + "pressure", h.Pressure);    number(k + "humidity", h.Humidity); number(k + "dew_point", h.DewPoint);
+    number(k + "pop", h.PoP);              number(k + "rain", h.Rainfall);    number(k + "snow", h.Snowfall);
+    fields[k + "icon"] = h.Icon.c_str();
+  }
+  for (int d = 0; d < 8; d++) {
+    Forecast_record_type& day = Daily[d];
+    std::string k = "d" + std::to_string(d) + ".";
+    number(k + "dt", day.Dt);              number(k + "temp", day.Temperature); number(k + "high", day.High);
+    number(k + "low", day.Low);            number(k + "humidity", day.Humidity); number(k + "pop", day.PoP);
+    number(k + "uvi", day.UVI);            number(k + "rain", day.Rainfall);    number(k + "snow", day.Snowfall);
+    fields[k + "summary"] = day.Description.c_str();
+    fields[k + "icon"]    = day.Icon.c_str();
+  }
+  return fields;
+}
+//#########################################################################################
+Fields_type ReadExpected(const std::string& path) {
+  Fields_type fields;
+  std::stringstream lines(ReadFile(path));
+  std::string line;
+  while (std::getline(lines, line)) {
+    size_t equals = line.find('=');
+    if (equals != std::string::npos) fields[line.substr(0, equals)] = line.substr(equals + 1);
+  }
+  return fields;
+}
+//#########################################################################################
+bool IsNumber(const std::string& text, double& value) {
+  char* end;
+  value = strtod(text.c_str(), &end);
+  return !text.empty() && *end == 0;
+}
+//#########################################################################################
+// Checks the decoded fields against the expected, a number to within 0.005 or 1 part in 10^6, as a float holds
+void CompareFields(const std::string& name, const Fields_type& decoded, const Fields_type& expected) {
+  for (auto& field : expected) {
+    auto found = decoded.find(field.first);
+    std::string what = name + " " + field.first;
+    if (!TestCheck(found != decoded.end(), (what + " decoded").c_str(), __FILE__, __LINE__)) continue;
+    double value, wanted;
+    if (IsNumber(field.second, wanted) && IsNumber(found->second, value)) {
+      TestNear(value, wanted, max(0.005, fabs(wanted) * 1e-6), what.c_str(), __FILE__, __LINE__);
+    }
+    else if (!TestCheck(found->second == field.second, what.c_str(), __FILE__, __LINE__)) {
+      fprintf(stderr, "  decoded '%s', expected '%s'\n", found->second.c_str(), field.second.c_str());
+    }
+  }
+}
+//#########################################################################################
+int main() {
+  struct {
+    const char*       Name;
+    Body_decoder_type Decode;
+  } decoders[] = {
+#ifdef HAVE_ARDUINOJSON
+    {"ArduinoJson", DecodeOneCallWeather},
+#endif
+    {"Streaming", DecodeOneCallStreamed},
+  };
+  std::vector<std::string> names = CorpusFiles("onecall_");
+  CHECK(names.size() > 0);
+  for (auto& name : names) {
+    std::string body     = ReadFile(CORPUS + name + ".json");
+    Fields_type expected = ReadExpected(CORPUS + name + ".expected");
+    for (auto& decoder : decoders) {
+      for (size_t chunk : {(size_t)0, (size_t)7}) { // Whole, and in the short reads of a slow connection
+        MemoryStream stream(body, chunk);
+        bool decoded = decoder.Decode(stream, false);
+        std::string what = name + " by " + decoder.Name + (chunk ? " in short reads" : "");
+        if (!TestCheck(decoded, (what + " decoded").c_str(), __FILE__, __LINE__)) continue;
+        CompareFields(what, RecordFields(), expected);
+      }
+    }
+  }
+  return TestResult("test_replay");
+}
@@ -0,0 +1,138 @@
+//
+// Checks the next wake NextScheduledWake() gives for a few schedules, and walks each of them wake by wake through
+// a year in a northern and a southern time zone: every wake is later than the last, within its rule's window, at
+// one of its local times and never at the same local time twice, across both DST changes.
+
+#include <Arduino.h>
+#include <set>
+#include "test.h"
+#include "schedule.h"
+
+#define LONDON "GMT0BST,M3.5.0/01,M10.5.0/02" // Clocks go forward 01:00 to 02:00 and back 02:00 to 01:00
+#define SYDNEY "AEST-10AEDT,M10.1.0,M4.1.0/3"  // Forward 02:00 to 03:00 in October, back 03:00 to 02:00 in April
+
+Schedule_rule_type Office[] = {{SCHEDULE_WEEKDAYS, 7 * 60, 18 * 60, 15}, {SCHEDULE_WEEKEND, 8 * 60, 22 * 60, 60}};
+Schedule_rule_type Always[] = {{SCHEDULE_EVERY_DAY, 0, 24 * 60, 30}};
+Schedule_rule_type Small[]  = {{SCHEDULE_EVERY_DAY, 60, 4 * 60, 30}}; // Across both DST changes in either zone
+
+//#########################################################################################
+void SetZone(const char* zone) {
+  setenv("TZ", zone, 1);
+  tzset();
+}
+//#########################################################################################
+// Local time, with isdst for the hour the clocks repeat, 1 the first time round and 0 the second
+time_t At(int year, int month, int day, int hour, int minute, int isdst = -1) {
+  struct tm t = {};
+  t.tm_year  = year - 1900;
+  t.tm_mon   = month - 1;
+  t.tm_mday  = day;
+  t.tm_hour  = hour;
+  t.tm_min   = minute;
+  t.tm_isdst = isdst;
+  return mktime(&t);
+}
+//#########################################################################################
+std::string Local(time_t t) {
+  struct tm local;
+  char      text[40];
+  localtime_r(&t, &local);
+  strftime(text, sizeof(text), "%a %Y-%m-%d %H:%M %Z", &local);
+  return text;
+}
+//#########################################################################################
+void Expect(const Schedule_rule_type rules[], int count, time_t now, time_t wanted, int line) {
+  time_t next = NextScheduledWake(rules, count, now);
+  if (!TestCheck(next == wanted, ("next wake after " + Local(now)).c_str(), __FILE__, line)) {
+    fprintf(stderr, "  got %s, expected %s\n", Local(next).c_str(), Local(wanted).c_str());
+  }
+}
+//#########################################################################################
+void TestNextWake() {
+  SetZone(LONDON);
+  Expect(Office, 2, At(2026, 6, 1, 12, 3),   At(2026, 6, 1, 12, 15), __LINE__); // Monday
+  Expect(Office, 2, At(2026, 6, 1, 12, 15),  At(2026, 6, 1, 12, 30), __LINE__); // On an update, so the one after
+  Expect(Office, 2, At(2026, 6, 1, 17, 50),  At(2026, 6, 2, 7, 0),   __LINE__); // After the last, 17:45
+  Expect(Office, 2, At(2026, 6, 5, 17, 46),  At(2026, 6, 6, 8, 0),   __LINE__); // Friday evening to Saturday
+  Expect(Office, 2, At(2026, 6, 6, 21, 30),  At(2026, 6, 7, 8, 0),   __LINE__); // Saturday's last is 21:00
+  Expect(Office, 2, At(2026, 6, 7, 22, 0),   At(2026, 6, 8, 7, 0),   __LINE__); // Sunday to Monday
+  Expect(Office, 2, At(2026, 6, 7, 3, 0),    At(2026, 6, 7, 8, 0),   __LINE__);
+  Expect(Always, 1, At(2026, 3, 29, 0, 45),  At(2026, 3, 29, 2, 0),  __LINE__); // 01:00 and 01:30 don't happen
+  Expect(Small,  1, At(2026, 3, 28, 12, 0),  At(2026, 3, 29, 2, 0),  __LINE__);
+  Expect(Always, 1, At(2026, 10, 25, 0, 50), At(2026, 10, 25, 1, 0, 1), __LINE__); // 01:00 BST, then not again in GMT
+
+  CHECK(NextScheduledWake(Office, 2, 1000) == 0); // The clock isn't set
+  CHECK(NextScheduledWake(Office, 0, At(2026, 6, 1, 0, 0)) == 0);
+  Schedule_rule_type never[] = {{SCHEDULE_EVERY_DAY, 8 * 60, 8 * 60, 15}};
+  CHECK(NextScheduledWake(never, 1, At(2026, 6, 1, 0, 0)) == 0);
+  CHECK(InSchedule(Office, 2, At(2026, 6, 1, 7, 0)) && !InSchedule(Office, 2, At(2026, 6, 1, 18, 0)));
+  CHECK(!InSchedule(Office, 2, 1000));
+}
+//#########################################################################################
+// The wakes on a day, as local times with the zone
+std::vector<std::string> WakesOn(const Schedule_rule_type rules[], int count, int year, int month, int day) {
+  std::vector<std::string> wakes;
+  time_t end = At(year, month, day + 1, 0, 0);
+  for (time_t t = NextScheduledWake(rules, count, At(year, month, day, 0, 0) - 1); t > 0 && t < end; t = NextScheduledWake(rules, count, t)) {
+    wakes.push_back(Local(t).substr(15));
+  }
+  return wakes;
+}
+//#########################################################################################
+void TestChangeDays() {
+  typedef std::vector<std::string> Wakes_type;
+  SetZone(LONDON);
+  CHECK((WakesOn(Small, 1, 2026, 3, 29) == Wakes_type{"02:00 BST", "02:30 BST", "03:00 BST", "03:30 BST"})); // Skipped ones later
+  CHECK((WakesOn(Small, 1, 2026, 10, 25).size() == 6)); // 01:00 and 01:30 once each, not in both BST and GMT
+  CHECK((WakesOn(Always, 1, 2026, 10, 25).size() == 48));
+  SetZone(SYDNEY);
+  CHECK((WakesOn(Small, 1, 2026, 10, 4) == Wakes_type{"01:00 AEST", "01:30 AEST", "03:00 AEDT", "03:30 AEDT"}));
+  CHECK((WakesOn(Small, 1, 2026, 4, 5).size() == 6));
+}
+//#########################################################################################
+// Walks the schedule through 2026, checking every wake, and returns how many there were
+int WalkYear(const Schedule_rule_type rules[], int count, const char* what) {
+  std::set<std::string> seen;
+  time_t end   = At(2027, 1, 1, 0, 0);
+  int    wakes = 0;
+  for (time_t t = At(2026, 1, 1, 0, 0) - 1;; wakes++) {
+    time_t next = NextScheduledWake(rules, count, t);
+    if (next >= end) break;
+    std::string when = std::string(what) + " " + Local(next);
+    if (!TestCheck(next > t, (when + " after the last wake").c_str(), __FILE__, __LINE__)) break;
+    TestCheck(InSchedule(rules, count, next), (when + " in schedule").c_str(), __FILE__, __LINE__);
+    struct tm local;
+    localtime_r(&next, &local);
+    int  minutes = local.tm_hour * 60 + local.tm_min;
+    bool slot    = false;
+    for (int r = 0; r < count; r++) {
+      slot |= (rules[r].Days & (1 << local.tm_wday)) && minutes >= rules[r].Start && minutes < rules[r].End &&
+              (minutes - rules[r].Start) % rules[r].Interval == 0;
+    }
+    TestCheck(slot && local.tm_sec == 0, (when + " on an update time").c_str(), __FILE__, __LINE__);
+    TestCheck(seen.insert(Local(next).substr(0, 20)).second, (when + " once").c_str(), __FILE__, __LINE__);
+    t = next;
+  }
+  return wakes;
+}
+//#########################################################################################
+void TestYear() {
+  const char* zones[][2] = {{"London", LONDON}, {"Sydney", SYDNEY}};
+  for (auto& zone : zones) {
+    SetZone(zone[1]);
+    std::string name = zone[0];
+    int office = WalkYear(Office, 2, (name + " office").c_str());
+    int always = WalkYear(Always, 1, (name + " every 30 minutes").c_str());
+    int small  = WalkYear(Small, 1, (name + " 01:00 to 04:00").c_str());
+    TestCheck(office == 261 * 44 + 104 * 14, (name + " office wakes " + std::to_string(office)).c_str(), __FILE__, __LINE__);
+    TestCheck(always == 365 * 48 - 2, (name + " every 30 minutes wakes " + std::to_string(always)).c_str(), __FILE__, __LINE__);
+    TestCheck(small == 365 * 6 - 2, (name + " 01:00 to 04:00 wakes " + std::to_string(small)).c_str(), __FILE__, __LINE__);
+  }
+}
+//#########################################################################################
+int main() {
+  TestNextWake();
+  TestChangeDays();
+  TestYear();
+  return TestResult("test_schedule");
+}
@@ -0,0 +1,71 @@
+//
+// Both ends of a gateway snapshot: the bytes the LAN gateway serves for a location are EncodeWire()'s, and a panel
+// stores them only if they're whole, undamaged, in its units and fresh enough, then shows the same forecast.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#define FETCH_TLS                         // So tls_client.h is built too,
+#define MBEDTLS_VERSION_NUMBER 0x021C0300 // for mbedtls 2.28 as test_locations builds it for 3.x
+#include "common.h"
+#include "http_fetch.h"
+#include "wire_format.h"
+#include "locations.h"
+#include "snapshot.h"
+
+Location_type Bath = {"BATH", "51.38", "-2.36"};
+
+//#########################################################################################
+// What LAN_Gateway's HandleSnapshot() sends for a location it has fetched
+std::string GatewayBody(const std::string& name) {
+  MemoryStream json(ReadFile(CORPUS + name + ".json"));
+  DecodeOneCallStreamed(json, false);
+  StoreLocation(0);
+  return std::string((const char*)LocationRecords[0].Wire, LocationRecords[0].Size);
+}
+//#########################################################################################
+bool Receive(const std::string& body, int length, uint32_t age) {
+  LocationRecords[1] = Location_record_type();
+  MemoryStream stream(body);
+  return StoreSnapshot(stream, length, age, Bath, 1);
+}
+//#########################################################################################
+int main() {
+  for (auto& name : CorpusFiles("onecall_")) {
+    std::string body = GatewayBody(name);
+    uint8_t encoded[WIRE_MAX_SIZE];
+    size_t  size = EncodeWire(encoded, sizeof(encoded), false);
+    TestCheck(body == std::string((const char*)encoded, size), (name + " served as EncodeWire() writes it").c_str(), __FILE__, __LINE__);
+    TestCheck(Receive(body, body.size(), 120), (name + " stored").c_str(), __FILE__, __LINE__);
+    CHECK(LocationFresh(Bath, 1, 300) && !LocationFresh(Bath, 1, 120));
+    CHECK(LoadLocation(1));
+    size_t again = EncodeWire(encoded, sizeof(encoded), false); // Shows what the gateway decoded
+    TestCheck(body == std::string((const char*)encoded, again), (name + " loaded as decoded").c_str(), __FILE__, __LINE__);
+    printf("%s: %zu byte snapshot\n", name.c_str(), body.size());
+  }
+  std::string body = GatewayBody("onecall_bath");
+  CHECK(Receive(body, body.size(), 0));
+  CHECK(!Receive(body, body.size(), LOCATION_MAX_STALE)); // Too old to show
+  CHECK(!Receive(body, body.size() + 1, 0));              // Shorter than the gateway said
+  CHECK(!Receive(body.substr(0, body.size() - 1), body.size() - 1, 0));
+  CHECK(!Receive(body, -1, 0));
+  CHECK(!Receive(std::string(LOCATION_WIRE_SIZE + 1, 'W'), LOCATION_WIRE_SIZE + 1, 0));
+  CHECK(LocationRecords[1].Fetched == 0);
+  Serial.Quiet = true;
+  for (size_t at = 0; at < body.size(); at++) { // Any damage is caught, by the header checks or the CRC
+    std::string damaged = body;
+    damaged[at] ^= 0x10;
+    TestCheck(!Receive(damaged, damaged.size(), 0), ("damaged at " + std::to_string(at)).c_str(), __FILE__, __LINE__);
+  }
+  Serial.Quiet = false;
+  Units = "I"; // A gateway set to the other units
+  CHECK(!Receive(body, body.size(), 0));
+  return TestResult("test_snapshot");
+}
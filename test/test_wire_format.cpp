@@ -0,0 +1,148 @@
+//
+// Round trips each One Call response in corpus/ through the wire format, with and without its texts, checks that
+// damaged or malformed data never changes the records, and reports the size of each form.
+
+#include <Arduino.h>
+#define ONECALL_STREAM_PARSER
+#include <WiFi.h>
+#include <zlib.h>
+#include <vector>
+#include "test.h"
+
+const char server[] = "api.openweathermap.org";
+String apikey = "", LAT = "51.38", LON = "-2.36", Language = "EN", Units = "M";
+
+#define max_readings 24
+#include "common.h"
+#include "wire_format.h"
+
+typedef std::vector<uint8_t> Wire_type;
+
+//#########################################################################################
+Wire_type Encode(bool texts) {
+  Wire_type wire(WIRE_MAX_SIZE);
+  wire.resize(EncodeWire(wire.data(), wire.size(), texts));
+  return wire;
+}
+//#########################################################################################
+// Sets the header's size and CRC to match the payload, as if it had been written that way
+Wire_type Sealed(Wire_type wire) {
+  size_t   length = wire.size() - WIRE_HEADER_SIZE;
+  uint32_t crc    = esp_rom_crc32_le(0, wire.data() + WIRE_HEADER_SIZE, length);
+  wire[4] = length;
+  wire[5] = length >> 8;
+  for (int b = 0; b < 4; b++) wire[6 + b] = crc >> (8 * b);
+  return wire;
+}
+//#########################################################################################
+// The records, with their texts, as the wire format holds them, to tell whether any of them changed
+Wire_type Records() {
+  return Encode(true);
+}
+//#########################################################################################
+void CheckSame(const std::vector<Forecast_record_type>& expected, bool texts, const std::string& what) {
+  auto near = [&](float value, float wanted, const char* field) {
+    TestNear(value, wanted, 0.0051, (what + " " + field).c_str(), __FILE__, __LINE__);
+  };
+  auto same = [&](const String& value, const String& wanted, const char* field) {
+    TestCheck(value == wanted, (what + " " + field + " '" + value.c_str() + "'").c_str(), __FILE__, __LINE__);
+  };
+  const Forecast_record_type& e = expected[0];
+  Forecast_record_type&       c = WxConditions[0];
+  TestCheck(c.Timezone == e.Timezone && c.Sunrise == e.Sunrise && c.Sunset == e.Sunset, (what + " times").c_str(), __FILE__, __LINE__);
+  near(c.Temperature, e.Temperature, "temperature"); near(c.FeelsLike, e.FeelsLike, "feels like"); near(c.Pressure, e.Pressure, "pressure");
+  near(c.Humidity, roundf(e.Humidity), "humidity");  near(c.DewPoint, e.DewPoint, "dew point");    near(c.UVI, e.UVI, "UVI");
+  near(c.Cloudcover, e.Cloudcover, "cloud cover");   near(c.Visibility, e.Visibility, "visibility"); near(c.Windspeed, e.Windspeed, "wind speed");
+  near(c.Winddir, roundf(e.Winddir), "wind direction");
+  same(c.Trend, e.Trend, "trend");
+  same(c.Icon, e.Icon, "icon");
+  same(c.Description, texts ? e.Description : "", "description");
+  for (int r = 0; r < max_readings; r++) {
+    const Forecast_record_type& h = expected[1 + r];
+    TestCheck(WxForecast[r].Dt == h.Dt, (what + " hour dt").c_str(), __FILE__, __LINE__);
+    near(WxForecast[r].Temperature, h.Temperature, "hour temperature"); near(WxForecast[r].FeelsLike, h.FeelsLike, "hour feels like");
+    near(WxForecast[r].Pressure, h.Pressure, "hour pressure");          near(WxForecast[r].Humidity, roundf(h.Humidity), "hour humidity");
+    near(WxForecast[r].DewPoint, h.DewPoint, "hour dew point");         near(WxForecast[r].PoP, h.PoP, "hour PoP");
+    near(WxForecast[r].Rainfall, h.Rainfall, "hour rain");              near(WxForecast[r].Snowfall, h.Snowfall, "hour snow");
+    same(WxForecast[r].Icon, h.Icon, "hour icon");
+  }
+  for (int d = 0; d < 8; d++) {
+    const Forecast_record_type& day = expected[1 + max_readings + d];
+    TestCheck(Daily[d].Dt == day.Dt, (what + " day dt").c_str(), __FILE__, __LINE__);
+    near(Daily[d].Temperature, day.Temperature, "day temperature"); near(Daily[d].High, day.High, "day high");
+    near(Daily[d].Low, day.Low, "day low");                         near(Daily[d].Humidity, roundf(day.Humidity), "day humidity");
+    near(Daily[d].PoP, day.PoP, "day PoP");                         near(Daily[d].UVI, day.UVI, "day UVI");
+    near(Daily[d].Rainfall, day.Rainfall, "day rain");              near(Daily[d].Snowfall, day.Snowfall, "day snow");
+    same(Daily[d].Icon, day.Icon, "day icon");
+    same(Daily[d].Description, texts ? day.Description : "", "day summary");
+  }
+}
+//#########################################################################################
+void ClearRecords() {
+  WxConditions[0] = Forecast_record_type();
+  for (int r = 0; r < max_readings; r++) WxForecast[r] = Forecast_record_type();
+  for (int d = 0; d < 8; d++) Daily[d] = Forecast_record_type();
+}
+//#########################################################################################
+void TestRoundTrip(const std::string& name) {
+  std::string json = ReadFile(CORPUS + name + ".json");
+  MemoryStream stream(json);
+  if (!TestCheck(DecodeOneCallStreamed(stream, false), (name + " decoded").c_str(), __FILE__, __LINE__)) return;
+  std::vector<Forecast_record_type> decoded = {WxConditions[0]};
+  decoded.insert(decoded.end(), WxForecast, WxForecast + max_readings);
+  decoded.insert(decoded.end(), Daily, Daily + 8);
+  Wire_type texts = Encode(true), bare = Encode(false);
+  for (bool withTexts : {true, false}) {
+    Wire_type& wire = withTexts ? texts : bare;
+    std::string what = name + (withTexts ? "" : " without texts");
+    ClearRecords();
+    if (!TestCheck(DecodeWire(wire.data(), wire.size()), (what + " wire decoded").c_str(), __FILE__, __LINE__)) continue;
+    CheckSame(decoded, withTexts, what);
+    TestCheck(Encode(withTexts) == wire, (what + " encodes again to the same bytes").c_str(), __FILE__, __LINE__);
+  }
+  uLongf gzipped = compressBound(json.size());
+  std::vector<Bytef> buffer(gzipped);
+  compress2(buffer.data(), &gzipped, (const Bytef*)json.data(), json.size(), 9);
+  printf("%-20s %8zu %8lu %8zu %8zu %7.1fx\n", name.c_str(), json.size(), gzipped, texts.size(), bare.size(), (double)json.size() / bare.size());
+}
+//#########################################################################################
+// Nothing malformed changes the records, even once its CRC is right
+void TestMalformed(const Wire_type& wire) {
+  Wire_type before = Records();
+  for (size_t at = 0; at < wire.size(); at++) {
+    Wire_type damaged = wire;
+    damaged[at] ^= 0x04;
+    TestCheck(!DecodeWire(damaged.data(), damaged.size()), ("damaged at " + std::to_string(at)).c_str(), __FILE__, __LINE__);
+  }
+  for (size_t size = 0; size < wire.size(); size++) CHECK(!DecodeWire(wire.data(), size));
+  Wire_type late = Sealed(Wire_type(wire.begin(), wire.end() - 1)); // The last varint runs off the end
+  CHECK(CheckWire(late.data(), late.size()) && !DecodeWire(late.data(), late.size()));
+  Wire_type runaway = wire; // A varint of more than five bytes part way through the hours
+  runaway.insert(runaway.end() - 100, {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+  runaway = Sealed(runaway);
+  CHECK(CheckWire(runaway.data(), runaway.size()) && !DecodeWire(runaway.data(), runaway.size()));
+  for (size_t cut = WIRE_HEADER_SIZE; cut < wire.size(); cut += 11) { // Payloads cut anywhere, resealed
+    Wire_type shorter = Sealed(Wire_type(wire.begin(), wire.begin() + cut));
+    TestCheck(!DecodeWire(shorter.data(), shorter.size()), ("cut at " + std::to_string(cut)).c_str(), __FILE__, __LINE__);
+  }
+  Wire_type unknown = wire;
+  unknown[3] |= 0x80;
+  CHECK(!DecodeWire(unknown.data(), unknown.size()));
+  Units = "I";
+  CHECK(!DecodeWire(wire.data(), wire.size()));
+  Units = "M";
+  CHECK(Records() == before);
+}
+//#########################################################################################
+int main() {
+  std::vector<std::string> names = CorpusFiles("onecall_");
+  CHECK(names.size() > 0);
+  printf("%-20s %8s %8s %8s %8s %8s\n", "Response", "JSON", "zlib", "Wire", "No texts", "Smaller");
+  for (auto& name : names) TestRoundTrip(name);
+  TestMalformed(Encode(true));
+  Wire_type small(8);
+  CHECK(EncodeWire(small.data(), small.size(), true) == 0);  // No room for a header
+  Wire_type tight(Encode(false).size() - 1);
+  CHECK(EncodeWire(tight.data(), tight.size(), false) == 0); // A byte short
+  return TestResult("test_wire_format");
+}